@@ -42,9 +42,11 @@ void bidirectional_stream_copy(Socket &socket) {
     _eventloop.add_rule(socket,
                         Direction::Out,
                         [&] {
-                            const size_t bytes_to_write = min(max_copy_length, _outbound.buffer_size());
-                            const size_t bytes_written = socket.write(_outbound.peek_output(bytes_to_write), false);
-                            _outbound.pop_output(bytes_written);
+                            const auto views = _outbound.peek_views(max_copy_length);
+                            BufferViewList buffer{views[0]};
+                            buffer.append(views[1]);
+                            const size_t bytes_written = socket.write(buffer, false);
+                            _outbound.consume(bytes_written);
                             if (_outbound.eof()) {
                                 socket.shutdown(SHUT_WR);
                                 _outbound_shutdown = true;
@@ -70,9 +72,11 @@ void bidirectional_stream_copy(Socket &socket) {
     _eventloop.add_rule(_output,
                         Direction::Out,
                         [&] {
-                            const size_t bytes_to_write = min(max_copy_length, _inbound.buffer_size());
-                            const size_t bytes_written = _output.write(_inbound.peek_output(bytes_to_write), false);
-                            _inbound.pop_output(bytes_written);
+                            const auto views = _inbound.peek_views(max_copy_length);
+                            BufferViewList buffer{views[0]};
+                            buffer.append(views[1]);
+                            const size_t bytes_written = _output.write(buffer, false);
+                            _inbound.consume(bytes_written);
 
                             if (_inbound.eof()) {
                                 _output.close();
@@ -0,0 +1,62 @@
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+using Kernel = InternetChecksum::Kernel;
+
+constexpr size_t bytes_per_run = 256 * 1024 * 1024;
+
+//! Checksum `bytes_per_run` bytes in `size`-byte pieces, the way segments and headers are checksummed
+static void run(const string &name, const Kernel kernel, const string &data, const size_t size) {
+    InternetChecksum::set_kernel(kernel);
+    const size_t rounds = bytes_per_run / size;
+    uint16_t sink = 0;  // keeps the loop from being optimized away
+
+    const auto first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < rounds; i++) {
+        InternetChecksum check(i);
+        check.add({data.data() + (i % 64), size});
+        sink ^= check.value();
+    }
+    const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+
+    const double gigabits_per_second = 8.0 * rounds * size / duration;
+    cout << left << setw(10) << name << right << setw(8) << size << fixed << setprecision(2) << setw(12)
+         << gigabits_per_second << setw(12) << double(duration) / rounds << "    (" << hex << sink << dec << ")\n";
+}
+
+int main() {
+    try {
+        string data(65536 + 64, 0);
+        for (auto &ch : data) {
+            ch = rand();
+        }
+
+        const vector<pair<string, Kernel>> kernels = {
+            {"bytewise", Kernel::Bytewise}, {"word", Kernel::Word}, {"sse2", Kernel::SSE2}, {"avx2", Kernel::AVX2}};
+
+        cout << left << setw(10) << "kernel" << right << setw(8) << "bytes" << setw(12) << "Gbit/s" << setw(12)
+             << "ns/call" << "\n";
+        for (const size_t size : {20, 40, 1000, 1460, 65536}) {
+            for (const auto &[name, kernel] : kernels) {
+                if (InternetChecksum::supported(kernel)) {
+                    run(name, kernel, data, size);
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+#include "io_uring.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Each turn stands in for a busy turn of TCPSpongeSocket's loop: a batch of datagrams out through
+// one UDP socket and in through another, plus a chunk of inbound bytes across the socketpair to
+// the owner. Only the writes differ between the two runs, as they do in TCPSpongeSocket.
+constexpr size_t DATAGRAM_SIZE = 1400;
+constexpr size_t BATCH = 32;
+constexpr size_t CHUNK_SIZE = 16384;
+constexpr size_t TURNS = 20000;
+
+static pair<FileDescriptor, FileDescriptor> socket_pair() {
+    int fds[2];
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, static_cast<int *>(fds)));
+    return {FileDescriptor{fds[0]}, FileDescriptor{fds[1]}};
+}
+
+//! Two connected loopback UDP sockets and a socketpair
+struct Loopback {
+    UDPSocket tx{}, rx{};
+    FileDescriptor app, thread;
+
+    explicit Loopback(pair<FileDescriptor, FileDescriptor> fds) : app(move(fds.first)), thread(move(fds.second)) {
+        rx.bind(Address("127.0.0.1", 0));
+        tx.connect(rx.local_address());
+    }
+};
+
+//! \brief Read a turn's datagrams and chunk back into reused strings, with a poll(2) whenever
+//! nothing is ready (the same for both runs)
+static void read_turn(Loopback &link, string &datagram, string &chunk) {
+    size_t datagrams = 0, bytes = 0;
+    while (datagrams < BATCH or bytes < CHUNK_SIZE) {
+        const short want_datagram = datagrams < BATCH ? POLLIN : 0, want_bytes = bytes < CHUNK_SIZE ? POLLIN : 0;
+        pollfd fds[2] = {{link.rx.fd_num(), want_datagram, 0}, {link.app.fd_num(), want_bytes, 0}};
+        SystemCall("poll", ::poll(static_cast<pollfd *>(fds), 2, -1));
+        if (fds[0].revents & POLLIN) {
+            link.rx.read(datagram, DATAGRAM_SIZE);
+            datagrams++;
+        }
+        if (fds[1].revents & POLLIN) {
+            link.app.read(chunk, CHUNK_SIZE - bytes);
+            bytes += chunk.size();
+        }
+    }
+}
+
+//! One system call per write: the FileDescriptor path
+static void run_poll(Loopback &link) {
+    const string datagram(DATAGRAM_SIZE, 'd'), chunk(CHUNK_SIZE, 'c');
+    string datagram_in, chunk_in;
+    for (size_t turn = 0; turn < TURNS; turn++) {
+        for (size_t i = 0; i < BATCH; i++) {
+            link.tx.write(datagram);
+        }
+        link.thread.write(chunk);
+        read_turn(link, datagram_in, chunk_in);
+    }
+}
+
+//! \brief The turn's writes wait on an io_uring, as in TCPSpongeSocket: the datagrams posted
+//! through the socket, the chunk from a registered buffer, and all handed over by one flush
+static void run_io_uring(Loopback &link) {
+    constexpr uint64_t CHUNK_OUT = 0;
+    IOUring ring{BATCH + 1, BATCH + 1, CHUNK_SIZE};
+    const size_t chunk_out = ring.acquire_buffer().value();
+    string(CHUNK_SIZE, 'c').copy(ring.buffer(chunk_out), CHUNK_SIZE);
+    link.tx.set_write_ring(&ring);
+
+    const string datagram(DATAGRAM_SIZE, 'd');
+    string datagram_in, chunk_in;
+    vector<IOUring::Completion> done;
+    for (size_t turn = 0; turn < TURNS; turn++) {
+        for (size_t i = 0; i < BATCH; i++) {
+            link.tx.write(datagram);
+        }
+        ring.write(link.thread, chunk_out, CHUNK_SIZE, CHUNK_OUT);
+        ring.flush();
+        done.clear();
+        ring.completions(done);
+        if (done.size() != 1 or done.front().result != int(CHUNK_SIZE)) {
+            throw runtime_error("short write to the socketpair");
+        }
+        read_turn(link, datagram_in, chunk_in);
+    }
+
+    link.tx.set_write_ring(nullptr);
+}
+
+static void report(const string &name, void (*run)(Loopback &)) {
+    Loopback link{socket_pair()};
+    const auto start = steady_clock::now();
+    run(link);
+    const double seconds = duration<double>(steady_clock::now() - start).count();
+    const double bytes = double(TURNS) * (BATCH * DATAGRAM_SIZE + CHUNK_SIZE);
+    cout << left << setw(10) << name << right << fixed << setprecision(2) << setw(10) << bytes * 8 / seconds / 1e9
+         << " Gbit/s" << setw(10) << seconds * 1e6 / TURNS << " us/turn\n";
+}
+
+int main() {
+    try {
+        cout << TURNS << " turns of " << BATCH << " " << DATAGRAM_SIZE << "-byte datagrams plus a " << CHUNK_SIZE
+             << "-byte socketpair chunk\n";
+        report("poll", run_poll);
+        if (IOUring::available()) {
+            report("io_uring", run_io_uring);
+        } else {
+            cout << "io_uring: unavailable (configure with -DSPONGE_IO_URING=ON, and run on Linux 5.19 or later)\n";
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
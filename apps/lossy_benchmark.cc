@@ -0,0 +1,137 @@
+#include "fd_adapter.hh"
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "util.hh"
+
+#include <poll.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+using Algorithm = CongestionControl::Algorithm;
+
+constexpr size_t len = 8 * 1024 * 1024;
+
+//! Give up on a run after this long (a sender without congestion control can take ages at high loss)
+constexpr uint64_t RUN_LIMIT_MS = 60 * 1000;
+
+//! One end of the link: a TCPConnection speaking TCP-over-UDP through a LossyFdAdapter
+struct Endpoint {
+    TCPConnection tcp;
+    LossyTCPOverUDPSocketAdapter link;
+};
+
+//! Hand everything `end` wants to send to its link; returns the payload bytes written
+static size_t flush(Endpoint &end) {
+    size_t bytes = 0;
+    while (not end.tcp.segments_out().empty()) {
+        bytes += end.tcp.segments_out().front().payload().size();
+        end.link.write(end.tcp.segments_out().front());
+        end.tcp.segments_out().pop();
+    }
+    return bytes;
+}
+
+//! \brief Send `len` bytes over loopback UDP, dropping `loss` of the data-carrying datagrams,
+//! with or without SACK
+static void run(const string &name, const Algorithm algorithm, const bool sack, const double loss) {
+    TCPConfig config;
+    config.rt_timeout = 20;  // loopback RTTs are microseconds; keep timeouts from dominating
+    config.recv_capacity = config.send_capacity = 256 * 1024;
+    config.congestion_control = algorithm;
+    config.sack = sack;
+
+    UDPSocket x_sock, y_sock;
+    x_sock.bind(Address("127.0.0.1", 0));
+    y_sock.bind(Address("127.0.0.1", 0));
+    const Address x_address = x_sock.local_address(), y_address = y_sock.local_address();
+
+    Endpoint x{TCPConnection{config}, LossyTCPOverUDPSocketAdapter{TCPOverUDPSocketAdapter{move(x_sock)}}};
+    Endpoint y{TCPConnection{config}, LossyTCPOverUDPSocketAdapter{TCPOverUDPSocketAdapter{move(y_sock)}}};
+    x.link.config_mut().source = y.link.config_mut().destination = x_address;
+    x.link.config_mut().destination = y.link.config_mut().source = y_address;
+    x.link.config_mut().loss_rate_up = static_cast<uint16_t>(loss * 65536);
+
+    const string data(len, 'x');
+    size_t written = 0, sent = 0, received = 0;
+    x.tcp.connect();
+
+    const uint64_t start = timestamp_ms();
+    uint64_t last_tick = start, elapsed = 0;
+    // keep going after the transfer until both sides have closed cleanly (timing only the transfer)
+    while ((x.tcp.active() or y.tcp.active()) and timestamp_ms() - start < RUN_LIMIT_MS) {
+        if (written < len and x.tcp.remaining_outbound_capacity() > 0) {
+            const size_t n = min(len - written, x.tcp.remaining_outbound_capacity());
+            written += x.tcp.write(data.substr(written, n));
+            if (written == len) {
+                x.tcp.end_input_stream();
+            }
+        }
+        sent += flush(x);
+        flush(y);
+
+        // wait (briefly) for something to arrive, then drain both sockets
+        pollfd fds[2] = {{static_cast<const FileDescriptor &>(x.link).fd_num(), POLLIN, 0},
+                         {static_cast<const FileDescriptor &>(y.link).fd_num(), POLLIN, 0}};
+        for (int timeout = 1; SystemCall("poll", ::poll(fds, 2, timeout)) > 0; timeout = 0) {
+            if (fds[0].revents & POLLIN) {
+                if (auto seg = x.link.read(); seg.has_value()) {
+                    x.tcp.segment_received(seg.value());
+                }
+            }
+            if (fds[1].revents & POLLIN) {
+                if (auto seg = y.link.read(); seg.has_value()) {
+                    y.tcp.segment_received(seg.value());
+                }
+            }
+        }
+        received += y.tcp.inbound_stream().read(y.tcp.inbound_stream().buffer_size()).size();
+        if (received == len and elapsed == 0) {
+            elapsed = max<uint64_t>(timestamp_ms() - start, 1);
+            y.tcp.end_input_stream();
+        }
+
+        const uint64_t now = timestamp_ms();
+        if (now > last_tick) {
+            x.tcp.tick(now - last_tick);
+            y.tcp.tick(now - last_tick);
+            last_tick = now;
+        }
+    }
+
+    cout << left << setw(14) << name + (sack ? "+sack" : "") << right << fixed << setprecision(1) << setw(7) << 100 * loss << "%";
+    if (received < len) {
+        cout << setw(12) << "timed out" << "\n";
+    } else {
+        cout << setw(12) << len * 8.0 / elapsed / 1000 << setw(14) << 100.0 * (sent - len) / len << "%\n";
+    }
+}
+
+int main() {
+    try {
+        const vector<pair<string, Algorithm>> algorithms = {
+            {"none", Algorithm::None}, {"newreno", Algorithm::NewReno}, {"cubic", Algorithm::Cubic}};
+
+        cout << left << setw(14) << "algorithm" << right << setw(8) << "loss" << setw(12) << "Mbit/s" << setw(15)
+             << "retransmitted\n";
+        for (const double loss : {0.0, 0.01, 0.05}) {
+            for (const auto &[name, algorithm] : algorithms) {
+                for (const bool sack : {false, true}) {
+                    run(name, algorithm, sack, loss);
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t default_len_mib = 4;
+constexpr size_t segment_size = 1000;
+
+//! Substrings to push, in order, for the window [base, base + capacity)
+using Segments = vector<pair<size_t, string>>;
+using PatternT = function<void(Segments &, const string &, size_t base, size_t capacity, mt19937 &)>;
+
+//! Append the substring of `data` at [index, index + size), clipped to the end of the stream
+static void add(Segments &segments, const string &data, const size_t index, const size_t size) {
+    if (index < data.size()) {
+        segments.emplace_back(index, data.substr(index, min(size, data.size() - index)));
+    }
+}
+
+static void in_order(Segments &segs, const string &data, const size_t base, const size_t capacity, mt19937 &) {
+    for (size_t index = base; index < base + capacity; index += segment_size) {
+        add(segs, data, index, min(segment_size, base + capacity - index));
+    }
+}
+
+static void reversed(Segments &segs, const string &data, const size_t base, const size_t capacity, mt19937 &rd) {
+    in_order(segs, data, base, capacity, rd);
+    reverse(segs.begin(), segs.end());
+}
+
+static void random_order(Segments &segs, const string &data, const size_t base, const size_t capacity, mt19937 &rd) {
+    in_order(segs, data, base, capacity, rd);
+    shuffle(segs.begin(), segs.end(), rd);
+}
+
+//! every segment three times, in random order
+static void duplicated(Segments &segs, const string &data, const size_t base, const size_t capacity, mt19937 &rd) {
+    for (size_t i = 0; i < 3; i++) {
+        in_order(segs, data, base, capacity, rd);
+    }
+    shuffle(segs.begin(), segs.end(), rd);
+}
+
+//! a 2-byte fragment starting at every byte, so each overlaps its neighbours by one byte
+static void tiny(Segments &segs, const string &data, const size_t base, const size_t capacity, mt19937 &rd) {
+    for (size_t index = base; index < base + capacity; index++) {
+        add(segs, data, index, min<size_t>(2, base + capacity - index));
+    }
+    shuffle(segs.begin(), segs.end(), rd);
+}
+
+//! 1.5x-long segments covering two windows, farthest first: half are dropped, one is truncated
+static void window_edge(Segments &segs, const string &data, const size_t base, const size_t capacity, mt19937 &) {
+    for (size_t index = base; index < base + 2 * capacity; index += segment_size) {
+        add(segs, data, index, segment_size + segment_size / 2);
+    }
+    reverse(segs.begin(), segs.end());
+}
+
+//! Reset the peak resident set size (Linux >= 4.0); \returns false if that is not possible
+static bool reset_peak_rss() {
+    ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    return clear_refs.good();
+}
+
+//! \returns the peak resident set size in KiB, from /proc/self/status
+static size_t peak_rss_kib() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return stoul(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+//! \details The peak RSS reported is the growth over a baseline taken once every window's substrings
+//! and the output string are built (and resident), so it measures the reassembler, not the harness.
+static void run(const string &name,
+                const PatternT &pattern,
+                const size_t capacity,
+                const StreamReassembler::Engine engine,
+                const string &data) {
+    auto rd = get_random_generator();
+    const size_t len = data.size();
+    vector<Segments> windows;
+    for (size_t base = 0; base < len; base += capacity) {
+        pattern(windows.emplace_back(), data, base, capacity, rd);
+    }
+    string received(len, '\0');
+    size_t received_len = 0;
+
+    malloc_trim(0);  // hand back what earlier runs freed, so the reassembler's allocations show up as growth
+    const bool rss_reset = reset_peak_rss();
+    const size_t baseline_kib = peak_rss_kib();
+
+    StreamReassembler reassembler{capacity, ByteStream::Storage::Ring, engine};
+    ByteStream &out = reassembler.stream_out();
+    nanoseconds duration{0};
+
+    for (const Segments &segments : windows) {
+        const auto first_time = high_resolution_clock::now();
+        for (const auto &[index, substring] : segments) {
+            reassembler.push_substring(substring, index, index + substring.size() == len);
+        }
+        // copy out into the space already reserved, rather than allocating a string per window
+        while (out.buffer_size() > 0) {
+            size_t copied = 0;
+            for (const string_view view : out.peek_views(out.buffer_size())) {
+                copied += view.copy(&received[received_len + copied], view.size());
+            }
+            out.consume(copied);
+            received_len += copied;
+        }
+        duration += duration_cast<nanoseconds>(high_resolution_clock::now() - first_time);
+    }
+
+    if (received_len != len or received != data or not out.eof()) {
+        throw runtime_error(name + ": reassembled stream doesn't match");
+    }
+
+    cout << left << setw(12) << name << right << setw(10) << capacity << "  " << left << setw(12)
+         << (engine == StreamReassembler::Engine::Bitmap ? "bitmap" : "interval map") << right << fixed
+         << setprecision(2) << setw(10) << double(duration.count()) / len << setw(12)
+         << (rss_reset ? to_string(peak_rss_kib() - baseline_kib) : string("n/a")) << "\n";
+}
+
+int main(int argc, char **argv) {
+    try {
+        if (argc > 2) {
+            cerr << "Usage: " << argv[0] << " [stream length in MiB, default " << default_len_mib << "]\n";
+            return EXIT_FAILURE;
+        }
+        const size_t len = (argc == 2 ? stoul(argv[1]) : default_len_mib) * 1024 * 1024;
+
+        string data(len, 'x');
+        for (auto &ch : data) {
+            ch = rand();
+        }
+
+        const vector<pair<string, PatternT>> patterns = {{"in-order", in_order},
+                                                         {"reversed", reversed},
+                                                         {"random", random_order},
+                                                         {"duplicated", duplicated},
+                                                         {"tiny", tiny},
+                                                         {"window-edge", window_edge}};
+
+        cout << left << setw(12) << "pattern" << right << setw(10) << "capacity" << "  " << left << setw(12)
+             << "engine" << right << setw(10) << "ns/byte" << setw(12) << "+peak KiB" << "\n";
+        for (const auto &[name, pattern] : patterns) {
+            for (const size_t capacity : {8000, 64000, 1000000}) {
+                for (const auto engine : {StreamReassembler::Engine::IntervalMap, StreamReassembler::Engine::Bitmap}) {
+                    run(name, pattern, capacity, engine, data);
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -28,8 +28,14 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+//! \param reorder deliver each batch of segments in reverse order
+//! \param large_window use 1 MiB buffers (advertised through window scaling) and Ethernet-sized segments
+void main_loop(const bool reorder, const bool large_window) {
     TCPConfig config;
+    if (large_window) {
+        config.recv_capacity = config.send_capacity = 1024 * 1024;
+        config.mss = 1460;
+    }
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -95,8 +101,8 @@ void main_loop(const bool reorder) {
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    cout << "CPU-limited throughput" << (large_window ? " (large window)" : "               ")
+         << (reorder ? " with reordering: " : "                : ") << gigabits_per_second << " Gbit/s\n";
 
     while (x.active() or y.active()) {
         loop();
@@ -105,8 +111,10 @@ void main_loop(const bool reorder) {
 
 int main() {
     try {
-        main_loop(false);
-        main_loop(true);
+        main_loop(false, false);
+        main_loop(true, false);
+        main_loop(false, true);
+        main_loop(true, true);
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
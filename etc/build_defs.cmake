@@ -4,3 +4,14 @@ macro (add_sponge_exec exec_name)
     add_executable ("${exec_name}" "${exec_name}.cc")
     target_link_libraries ("${exec_name}" ${ARGN} sponge ${LIBPTHREAD})
 endmacro (add_sponge_exec)
+
+option (SPONGE_IO_URING "Build the io_uring I/O backend (used at run time only if the kernel supports it)" OFF)
+if (SPONGE_IO_URING)
+    include (CheckIncludeFileCXX)
+    check_include_file_cxx ("linux/io_uring.h" HAVE_LINUX_IO_URING_H)
+    if (HAVE_LINUX_IO_URING_H)
+        add_definitions (-DSPONGE_IO_URING)
+    else ()
+        message (WARNING "SPONGE_IO_URING is on, but linux/io_uring.h was not found; building without io_uring")
+    endif ()
+endif ()
@@ -21,6 +21,11 @@ add_test(NAME t_send_window          COMMAND send_window)
 add_test(NAME t_send_ack             COMMAND send_ack)
 add_test(NAME t_send_close           COMMAND send_close)
 add_test(NAME t_send_extra           COMMAND send_extra)
+add_test(NAME t_send_congestion      COMMAND send_congestion)
+add_test(NAME t_send_rto             COMMAND send_rto)
+add_test(NAME t_send_sack            COMMAND send_sack)
+add_test(NAME t_send_nagle           COMMAND send_nagle)
+add_test(NAME t_send_pacing          COMMAND send_pacing)
 
 add_test(NAME t_strm_reassem_single      COMMAND fsm_stream_reassembler_single)
 add_test(NAME t_strm_reassem_seq         COMMAND fsm_stream_reassembler_seq)
@@ -30,12 +35,25 @@ add_test(NAME t_strm_reassem_many        COMMAND fsm_stream_reassembler_many)
 add_test(NAME t_strm_reassem_overlapping COMMAND fsm_stream_reassembler_overlapping)
 add_test(NAME t_strm_reassem_win         COMMAND fsm_stream_reassembler_win)
 add_test(NAME t_strm_reassem_cap         COMMAND fsm_stream_reassembler_cap)
+add_test(NAME t_strm_reassem_bitmap      COMMAND fsm_stream_reassembler_bitmap)
 
 add_test(NAME t_byte_stream_construction COMMAND byte_stream_construction)
 add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
 add_test(NAME t_byte_stream_two_writes   COMMAND byte_stream_two_writes)
 add_test(NAME t_byte_stream_capacity     COMMAND byte_stream_capacity)
 add_test(NAME t_byte_stream_many_writes  COMMAND byte_stream_many_writes)
+add_test(NAME t_byte_stream_views        COMMAND byte_stream_views)
+add_test(NAME t_byte_stream_chunked      COMMAND byte_stream_chunked)
+
+add_test(NAME t_slab_pool              COMMAND slab_pool)
+add_test(NAME t_internet_checksum      COMMAND internet_checksum)
+add_test(NAME t_tcp_options            COMMAND tcp_options)
+add_test(NAME t_tcp_delayed_ack        COMMAND tcp_delayed_ack)
+add_test(NAME t_event_loop             COMMAND event_loop)
+add_test(NAME t_io_uring               COMMAND io_uring)
+add_test(NAME t_tcp_mux                COMMAND tcp_mux)
+add_test(NAME t_tcp_mux_listen         COMMAND tcp_mux_listen)
+add_test(NAME t_timer_wheel            COMMAND timer_wheel)
 
 add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh")
 
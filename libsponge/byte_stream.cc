@@ -1,5 +1,8 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
+#include <cstring>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,45 +15,177 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity) : cap(capacity) {
+//! \returns the smallest power of two that is at least `n` (and at least 1)
+static size_t round_up_pow2(const size_t n) {
+    size_t ret = 1;
+    while (ret < n) {
+        ret <<= 1;
+    }
+    return ret;
 }
 
-size_t ByteStream::write(const string &data) {
-    size_t rem = remaining_capacity();
-    size_t can_wr = data.size();
-    if (data.size() > rem) {
-        can_wr = rem;
+//! \param[in] capacity is the maximum number of bytes buffered at once
+//! \param[in] storage selects the ring buffer (default) or the queue of Buffers
+ByteStream::ByteStream(const size_t capacity, const Storage storage)
+    : _storage(storage)
+    , _ring(storage == Storage::Ring ? round_up_pow2(capacity) : 0)
+    , _mask(_ring.empty() ? 0 : _ring.size() - 1)
+    , cap(capacity) {}
+
+//! \details With Storage::Ring, bytes live at `_ring[position & _mask]`, where the write
+//! position is bytes_written() and the read position is bytes_read(). A range
+//! crosses the end of the ring at most once, so every copy is one or two memcpy calls.
+size_t ByteStream::write(string_view data) {
+    const size_t can_wr = min(data.size(), remaining_capacity());
+    if (can_wr == 0) {
+        return 0;
     }
-    this->wr += can_wr;
-    for (size_t i = 0; i < can_wr; ++i) {
-        q.push_back(data[i]);
+    if (_storage == Storage::Chunked and can_wr < COPY_BELOW) {
+        append_copy(data.substr(0, can_wr));
+    } else if (_storage == Storage::Chunked) {
+        _chunks.emplace_back(string(data.substr(0, can_wr)));
+    } else {
+        const size_t start = wr & _mask;
+        const size_t first = min(can_wr, _ring.size() - start);
+        memcpy(_ring.data() + start, data.data(), first);
+        memcpy(_ring.data(), data.data() + first, can_wr - first);
     }
+    this->wr += can_wr;
     return can_wr;
 }
 
-//! \param[in] len bytes will be copied from the output side of the buffer
-string ByteStream::peek_output(const size_t len) const {
-    return string().assign(q.begin(), q.begin() + min(len, q.size()));
+size_t ByteStream::write(const string &data) { return write(string_view(data)); }
+
+//! \details A Buffer that is small, or does not fit entirely, is copied (in part);
+//! otherwise, with Storage::Chunked, it is queued without copying its bytes.
+//! (Keeping a small Buffer by reference would hold on to everything it was sliced from:
+//! a 1-byte payload would pin a whole received datagram.)
+size_t ByteStream::write(const Buffer &data) {
+    if (_storage == Storage::Ring or data.size() < COPY_BELOW or data.size() > remaining_capacity()) {
+        return write(data.str());
+    }
+    _chunks.push_back(data);
+    this->wr += data.size();
+    return data.size();
+}
+
+//! \details Consecutive small writes share a slab, and grow the last chunk when it ends where they
+//! begin. The slab's bytes are never rewritten, so chunks (and Buffers returned by read_buffer())
+//! viewing its earlier bytes stay valid.
+void ByteStream::append_copy(const string_view data) {
+    if (not _tail or _tail.size() + data.size() > Slab::CAPACITY) {
+        _tail = Slab::allocate();
+    }
+    const string_view written = _tail.str();
+    const bool grow = not _chunks.empty() and _chunks.back().size() > 0 and
+                      _chunks.back().str().data() + _chunks.back().size() == written.data() + written.size();
+    _tail.append(data);
+
+    // the new chunk starts where the last one did (if it grows) or at the new bytes
+    Buffer chunk{Slab{_tail}};
+    chunk.remove_prefix(written.size() - (grow ? _chunks.back().size() : 0));
+    if (grow) {
+        _chunks.back() = move(chunk);
+    } else {
+        _chunks.push_back(move(chunk));
+    }
+}
+
+//! \param[in] len bytes will be viewed from the output side of the buffer
+array<string_view, 2> ByteStream::peek_views(const size_t len) const {
+    const size_t can_rd = min(len, buffer_size());
+    if (_storage == Storage::Chunked) {
+        array<string_view, 2> ret{};
+        size_t remain = can_rd;
+        for (size_t i = 0; i < ret.size() and i < _chunks.size() and remain > 0; ++i) {
+            ret[i] = _chunks[i].str().substr(0, remain);
+            remain -= ret[i].size();
+        }
+        return ret;
+    }
+    const size_t start = rd & _mask;
+    const size_t first = min(can_rd, _ring.size() - start);
+    return {string_view(_ring.data() + start, first), string_view(_ring.data(), can_rd - first)};
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
-void ByteStream::pop_output(const size_t len) {
-    size_t can_pop = min(q.size(), len);
+void ByteStream::consume(const size_t len) {
+    const size_t can_pop = min(len, buffer_size());
     this->rd += can_pop;
-    for (size_t i = 0; i < can_pop; ++i) {
-        q.pop_front();
+    if (_storage == Storage::Chunked) {
+        size_t remain = can_pop;
+        while (remain > 0) {
+            if (remain < _chunks.front().size()) {
+                _chunks.front().remove_prefix(remain);
+                remain = 0;
+            } else {
+                remain -= _chunks.front().size();
+                _chunks.pop_front();
+            }
+        }
+    }
+}
+
+//! \param[in] len bytes will be copied from the output side of the buffer
+string ByteStream::peek_output(const size_t len) const {
+    string ret;
+    ret.reserve(min(len, buffer_size()));
+    if (_storage == Storage::Chunked) {
+        for (auto it = _chunks.begin(); it != _chunks.end() and ret.size() < len; ++it) {
+            ret.append(it->str().substr(0, len - ret.size()));
+        }
+        return ret;
     }
+    const auto views = peek_views(len);
+    ret.append(views[0]).append(views[1]);
+    return ret;
 }
 
+//! \param[in] len bytes will be removed from the output side of the buffer
+void ByteStream::pop_output(const size_t len) { consume(len); }
+
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
 //! \param[in] len bytes will be popped and returned
 //! \returns a string
 std::string ByteStream::read(const size_t len) {
-    const string &output = peek_output(len);
+    string output = peek_output(len);
     pop_output(len);
     return output;
 }
 
+//! \param[in] len is the maximum number of bytes to pop and return
+Buffer ByteStream::read_buffer(const size_t len) {
+    if (_storage == Storage::Chunked and not buffer_empty() and _chunks.front().size() <= len) {
+        Buffer ret = move(_chunks.front());
+        _chunks.pop_front();
+        this->rd += ret.size();
+        return ret;
+    }
+    // a partial chunk (or the ring) has to be copied out
+    return read(len);
+}
+
+//! \param[in] len is the maximum number of bytes to pop and return
+//! \param[in] headroom is the number of bytes to leave free in front of them
+Buffer ByteStream::read_with_headroom(const size_t len, const size_t headroom) {
+    const size_t n = min(len, buffer_size());
+    if (n == 0) {
+        return {};
+    }
+    if (headroom + n > Slab::CAPACITY) {
+        return read(n);
+    }
+
+    Slab packet = Slab::allocate(headroom);
+    while (packet.size() < n) {
+        const auto views = peek_views(n - packet.size());
+        packet.append(views[0]);
+        packet.append(views[1]);
+        consume(views[0].size() + views[1].size());
+    }
+    return Buffer{move(packet)};
+}
+
 void ByteStream::end_input() {
     input_end = true;
 }
@@ -60,15 +195,15 @@ bool ByteStream::input_ended() const {
 }
 
 size_t ByteStream::buffer_size() const {
-    return q.size();
+    return this->wr - this->rd;
 }
 
 bool ByteStream::buffer_empty() const {
-    return !q.size();
+    return buffer_size() == 0;
 }
 
 bool ByteStream::eof() const {
-    return input_ended() && !q.size();
+    return input_ended() && buffer_empty();
 }
 
 size_t ByteStream::bytes_written() const {
@@ -80,5 +215,5 @@ size_t ByteStream::bytes_read() const {
 }
 
 size_t ByteStream::remaining_capacity() const {
-    return this->cap - q.size();
-}
\ No newline at end of file
+    return this->cap - buffer_size();
+}
@@ -1,8 +1,13 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+
+#include <array>
+#include <deque>
 #include <string>
-#include <queue>
+#include <string_view>
+#include <vector>
 
 //! \brief An in-order byte stream.
 
@@ -10,9 +15,28 @@
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
 class ByteStream {
+  public:
+    //! How the stream holds buffered bytes
+    enum class Storage {
+        Ring,    //!< Copy bytes into a preallocated ring buffer
+        Chunked  //!< Keep a queue of reference-counted Buffers; written Buffers are not copied
+    };
+
+    //! Buffers smaller than this are copied rather than kept by reference, so that a few bytes
+    //! don't hold on to the whole datagram or slab they were sliced from
+    static constexpr size_t COPY_BELOW = Slab::CAPACITY / 4;
+
   private:
     // Your code here -- add private members as necessary.
-    std::deque<char> q = {};
+    Storage _storage;
+    //! Ring storage, sized to a power of two no smaller than `cap` so
+    //! positions wrap with a mask instead of a division (Storage::Ring only)
+    std::vector<char> _ring;
+    size_t _mask;
+    std::deque<Buffer> _chunks{};  //!< Buffered slices, oldest first (Storage::Chunked only)
+    //! Slab that small writes are copied into, so a tiny payload doesn't pin the whole
+    //! datagram or slab it arrived in (Storage::Chunked only)
+    Slab _tail{};
     size_t cap = 0, wr = 0, rd = 0;
     bool input_end = 0;
     // Hint: This doesn't need to be a sophisticated data structure at
@@ -22,9 +46,12 @@ class ByteStream {
 
     bool _error{};  //!< Flag indicating that the stream suffered an error.
 
+    //! Copy `data` (which must fit) onto the end of the stream through `_tail` (Storage::Chunked only)
+    void append_copy(std::string_view data);
+
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    ByteStream(const size_t capacity, const Storage storage = Storage::Ring);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -34,6 +61,15 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Copy as many bytes of `data` as will fit into the stream
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string_view data);
+
+    //! Write a Buffer into the stream. With Storage::Chunked, a Buffer that fits
+    //! is queued by reference instead of being copied (unless it is small).
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const Buffer &data);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
@@ -54,10 +90,29 @@ class ByteStream {
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
+    //! View the next "len" bytes of the stream without copying them
+    //! \returns two string_views over the buffer; the second is empty unless the bytes
+    //! wrap around the end of the ring. The views stay valid until the bytes are consumed.
+    //! \note With Storage::Chunked, the views cover at most the first two chunks,
+    //! so they may hold fewer than "len" bytes even if more are buffered.
+    std::array<std::string_view, 2> peek_views(const size_t len) const;
+
+    //! Remove the next "len" bytes from the buffer (e.g. after writing out peek_views())
+    void consume(const size_t len);
+
     //! Read (i.e., copy and then pop) the next "len" bytes of the stream
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read (i.e., pop) up to "len" bytes of the stream as a Buffer
+    //! \returns a Buffer; with Storage::Chunked this is the front chunk itself when it
+    //! fits in "len", and it never spans more than one chunk (fewer bytes may be returned)
+    Buffer read_buffer(const size_t len);
+
+    //! Read (i.e., copy and then pop) up to "len" bytes into a pooled Slab with "headroom" free bytes in front
+    //! \returns a Buffer that lower layers can prepend their headers to in place (see BufferList::prepend)
+    Buffer read_with_headroom(const size_t len, const size_t headroom);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
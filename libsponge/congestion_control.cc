@@ -0,0 +1,111 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+unique_ptr<CongestionControl> CongestionControl::make(const Algorithm algorithm, const size_t mss) {
+    switch (algorithm) {
+        case Algorithm::NewReno:
+            return make_unique<NewReno>(mss);
+        case Algorithm::Cubic:
+            return make_unique<Cubic>(mss);
+        case Algorithm::None:
+            break;
+    }
+    return nullptr;
+}
+
+//! \details The initial window is ten segments ([RFC 6928](https://tools.ietf.org/html/rfc6928)),
+//! and the slow start threshold starts out unbounded.
+CongestionControl::CongestionControl(const size_t mss)
+    : _mss(mss), _cwnd(10 * mss), _ssthresh(numeric_limits<size_t>::max()) {}
+
+//! \details Slow start counts acknowledged bytes ([RFC 3465](https://tools.ietf.org/html/rfc3465))
+//! without the per-ACK limit, so stretch ACKs covering many segments still double the window each round trip.
+void CongestionControl::on_ack(const size_t acked, const uint64_t now_ms, const optional<double> srtt_ms) {
+    if (_cwnd < _ssthresh) {
+        _cwnd = min(_cwnd + acked, max(_ssthresh, _cwnd));
+        return;
+    }
+    congestion_avoidance(acked, now_ms, srtt_ms);
+}
+
+void CongestionControl::on_fast_retransmit(const uint64_t now_ms) {
+    _ssthresh = max(reduced_window(now_ms), 2 * _mss);
+    _cwnd = _ssthresh + 3 * _mss;
+}
+
+void CongestionControl::on_partial_ack(const size_t acked) {
+    // deflate by the data that left, then add back the segment retransmitted for the next hole
+    _cwnd = max(_cwnd > acked ? _cwnd - acked : 0, _mss) + (acked >= _mss ? _mss : 0);
+}
+
+void CongestionControl::on_timeout(const uint64_t now_ms) {
+    _ssthresh = max(reduced_window(now_ms), 2 * _mss);
+    _cwnd = _mss;
+}
+
+void CongestionControl::set_mss(const size_t mss) {
+    _cwnd = _cwnd / _mss * mss;
+    _mss = mss;
+}
+
+void NewReno::congestion_avoidance(const size_t acked, const uint64_t, const optional<double>) {
+    _acked_in_window += acked;
+    while (_acked_in_window >= _cwnd) {
+        _acked_in_window -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+size_t NewReno::reduced_window(const uint64_t) {
+    _acked_in_window = 0;
+    return _cwnd / 2;
+}
+
+//! \details The window grows towards max(W_cubic(t + SRTT), W_est): the cubic curve through _w_max
+//! one round trip ahead, or the window standard TCP would have reached since the epoch began, whichever
+//! is larger. As in [RFC 9438](https://tools.ietf.org/html/rfc9438) section 4.2, the target is capped
+//! at 1.5 * cwnd, so however far the curve has run ahead (after a long epoch, or an idle period), the
+//! window grows by at most half of itself per round trip.
+void Cubic::congestion_avoidance(const size_t acked, const uint64_t now_ms, const optional<double> srtt_ms) {
+    const double mss = static_cast<double>(_mss);
+    const double cwnd = static_cast<double>(_cwnd) / mss;
+    if (not _epoch.has_value()) {
+        // first congestion avoidance ACK since the last loss (or since slow start ended)
+        _epoch = now_ms;
+        if (_w_max < cwnd) {
+            _w_max = cwnd;
+        }
+        _k = cbrt((_w_max - cwnd) / C);
+        _w_est = cwnd;
+    }
+
+    const double t = (static_cast<double>(now_ms - _epoch.value()) + srtt_ms.value_or(0)) / 1000.0;
+    const double w_cubic = C * pow(t - _k, 3) + _w_max;
+    _w_est += 3 * (1 - BETA) / (1 + BETA) * (static_cast<double>(acked) / mss) / cwnd;
+
+    const double target = min(max(w_cubic, _w_est), 1.5 * cwnd);
+    if (target > cwnd) {
+        // (target - cwnd) / cwnd segments per segment acknowledged, applied a whole segment at a time
+        // (as NewReno does): a window that opens by a few bytes per ACK gets filled with runt segments
+        _increase += (target - cwnd) / cwnd * static_cast<double>(acked);
+        while (_increase >= mss) {
+            _increase -= mss;
+            _cwnd += _mss;
+        }
+    }
+}
+
+size_t Cubic::reduced_window(const uint64_t) {
+    const double cwnd = static_cast<double>(_cwnd) / static_cast<double>(_mss);
+    // fast convergence: release bandwidth faster when losses come earlier than last time
+    _w_max = cwnd < _w_last_max ? cwnd * (1 + BETA) / 2 : cwnd;
+    _w_last_max = cwnd;
+    _epoch.reset();
+    _increase = 0;
+    return static_cast<size_t>(lround(cwnd * BETA)) * _mss;
+}
@@ -0,0 +1,112 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+//! \brief The congestion window of a TCPSender, and the algorithm that grows and shrinks it
+//! \details The TCPSender detects the events (new data acknowledged, three duplicate ACKs,
+//! a retransmission timeout) and runs [NewReno](https://tools.ietf.org/html/rfc6582) fast
+//! recovery itself; subclasses only decide how the window reacts. The base class implements
+//! slow start and the [RFC 5681](https://tools.ietf.org/html/rfc5681) responses to loss,
+//! leaving congestion avoidance and the multiplicative decrease to the algorithm.
+//!
+//! All windows are in bytes; time is the sender's clock, in milliseconds.
+class CongestionControl {
+  public:
+    //! Which algorithm a TCPSender uses
+    enum class Algorithm {
+        None,     //!< no congestion window: send whatever the peer's window allows
+        NewReno,  //!< [RFC 5681](https://tools.ietf.org/html/rfc5681) AIMD
+        Cubic     //!< [RFC 8312](https://tools.ietf.org/html/rfc8312) cubic growth
+    };
+
+    //! \brief Create the congestion controller for `algorithm` (nullptr for Algorithm::None)
+    static std::unique_ptr<CongestionControl> make(const Algorithm algorithm, const size_t mss);
+
+  protected:
+    size_t _mss;       //!< sender's maximum segment size
+    size_t _cwnd;      //!< congestion window
+    size_t _ssthresh;  //!< slow start threshold
+
+    //! \brief Grow the window in congestion avoidance, after `acked` bytes were acknowledged
+    virtual void congestion_avoidance(const size_t acked,
+                                      const uint64_t now_ms,
+                                      const std::optional<double> srtt_ms) = 0;
+
+    //! \brief The slow start threshold after a loss, given the window (`_cwnd`) when it happened
+    virtual size_t reduced_window(const uint64_t now_ms) = 0;
+
+  public:
+    explicit CongestionControl(const size_t mss);
+    virtual ~CongestionControl() = default;
+
+    //! \brief The congestion window: how many bytes may be in flight
+    size_t cwnd() const { return _cwnd; }
+
+    //! \brief The slow start threshold
+    size_t ssthresh() const { return _ssthresh; }
+
+    //! \brief `acked` bytes of new data were acknowledged outside of fast recovery
+    //! \param srtt_ms the sender's smoothed round-trip time, once it has one
+    void on_ack(const size_t acked, const uint64_t now_ms, const std::optional<double> srtt_ms = {});
+
+    //! \brief Three duplicate ACKs arrived: reduce the window and inflate it by the three segments that left
+    void on_fast_retransmit(const uint64_t now_ms);
+
+    //! \brief Another duplicate ACK arrived during fast recovery: one more segment left the network
+    void on_duplicate_ack() { _cwnd += _mss; }
+
+    //! \brief A partial ACK acknowledged `acked` bytes during fast recovery (RFC 6582 deflation)
+    void on_partial_ack(const size_t acked);
+
+    //! \brief Everything outstanding when fast recovery began has been acknowledged
+    void on_recovery_exit() { _cwnd = _ssthresh; }
+
+    //! \brief The retransmission timer expired: back to slow start from one segment
+    void on_timeout(const uint64_t now_ms);
+
+    //! \brief The sender's MSS changed (before any data was sent): keep the window the same number of segments
+    void set_mss(const size_t mss);
+};
+
+//! \brief [RFC 5681](https://tools.ietf.org/html/rfc5681) congestion avoidance: one segment per window of ACKed data
+class NewReno : public CongestionControl {
+    size_t _acked_in_window{};  //!< bytes acknowledged since the window last grew
+
+  protected:
+    void congestion_avoidance(const size_t acked,
+                              const uint64_t now_ms,
+                              const std::optional<double> srtt_ms) override;
+    size_t reduced_window(const uint64_t now_ms) override;
+
+  public:
+    explicit NewReno(const size_t mss) : CongestionControl(mss) {}
+};
+
+//! \brief [RFC 8312](https://tools.ietf.org/html/rfc8312) CUBIC: the window follows a cubic
+//! function of the time since the last loss, plateauing around the window where that loss happened
+class Cubic : public CongestionControl {
+    static constexpr double C = 0.4;     //!< scaling constant, in segments/s^3
+    static constexpr double BETA = 0.7;  //!< multiplicative decrease factor
+
+    double _w_max{};                   //!< window (in segments) just before the last reduction
+    double _w_last_max{};              //!< previous _w_max, for fast convergence
+    double _k{};                       //!< seconds the cubic takes to climb back to _w_max
+    double _w_est{};                   //!< Reno-friendly estimate of the window, in segments
+    double _increase{};                //!< bytes of growth not yet applied as a whole segment
+    std::optional<uint64_t> _epoch{};  //!< start of the current congestion avoidance period
+
+  protected:
+    void congestion_avoidance(const size_t acked,
+                              const uint64_t now_ms,
+                              const std::optional<double> srtt_ms) override;
+    size_t reduced_window(const uint64_t now_ms) override;
+
+  public:
+    explicit Cubic(const size_t mss) : CongestionControl(mss) {}
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
@@ -81,7 +81,10 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
         // Learn mappings from both requests and replies
         uint32_t sender_ip = rev_arp.sender_ip_address;
         _address_map[sender_ip] = rev_arp.sender_ethernet_address;
-        _last_rev_arp[sender_ip] = _tick;
+        if (_arp_timer.count(sender_ip)) {
+            _arp_expiry.cancel(_arp_timer[sender_ip]);
+        }
+        _arp_timer[sender_ip] = _arp_expiry.schedule(_tick + 30 * 1000 + 1, sender_ip);
         // for me ?
         if (rev_arp.target_ip_address == _ip_address.ipv4_numeric()) {
             if (rev_arp.opcode == ARPMessage::OPCODE_REQUEST) {
@@ -108,12 +111,18 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void NetworkInterface::tick(const size_t ms_since_last_tick) {
     _tick += ms_since_last_tick;
-    for (auto it = _address_map.begin(); it != _address_map.end();){
-        auto nxt = it;
-        nxt++;
-        if (_tick - _last_rev_arp[it->first] > 30 * 1000){
-            _address_map.erase(it);
-        }
-        it = nxt;
+    _arp_expiry.advance(_tick, [&](const uint32_t ip) {
+        _address_map.erase(ip);
+        _arp_timer.erase(ip);
+    });
+}
+
+//! \details The wheel's next expiry may come before the deadline itself (when its timers cascade); ticking then
+//! moves them closer, and the next call reports the rest.
+optional<size_t> NetworkInterface::next_timeout() const {
+    const auto next = _arp_expiry.next_expiry();
+    if (not next.has_value()) {
+        return {};
     }
+    return next.value() - _tick;
 }
@@ -3,6 +3,7 @@
 
 #include "ethernet_frame.hh"
 #include "tcp_over_ip.hh"
+#include "timer_wheel.hh"
 #include "tun.hh"
 
 #include <optional>
@@ -51,7 +52,10 @@ private:
 
     std::unordered_map<uint32_t, uint64_t> _last_sent_arp{};
 
-    std::unordered_map<uint32_t, uint64_t> _last_rev_arp{};
+    //! each learned mapping expires 30 s after it was last heard; tick() only visits those whose time is up
+    TimerWheel<uint32_t> _arp_expiry{};
+
+    std::unordered_map<uint32_t, TimerWheel<uint32_t>::TimerId> _arp_timer{};
 
     uint64_t _tick{0};
     /* my code */
@@ -81,6 +85,10 @@ public:
 
     //! \brief Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Milliseconds until tick() has something to do: a learned mapping expires (empty if none is held)
+    //! \note ARP requests are only re-sent by send_datagram, so they set no deadline of their own
+    std::optional<size_t> next_timeout() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_NETWORK_INTERFACE_HH
@@ -1,52 +1,152 @@
-#include <cassert>
 #include "stream_reassembler.hh"
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity) : _output(capacity), _capacity(capacity) {}
+//! \returns the number of consecutive one bits starting at the least significant bit
+static size_t countr_one(const uint64_t x) { return ~x == 0 ? 64 : __builtin_ctzll(~x); }
 
-bool StreamReassembler::seg_overlap(const Seg &s1, const Seg &s2) const{
-    return !(s1.r + 1 < s2.l || s1.l > s2.r + 1);
+//! \param[in] capacity is the maximum number of bytes held (assembled or not)
+//! \param[in] storage selects how the output ByteStream holds its bytes
+//! \param[in] engine selects how out-of-order bytes are held
+StreamReassembler::StreamReassembler(const size_t capacity, const ByteStream::Storage storage, const Engine engine)
+    : _engine(engine), _output(capacity, storage), _capacity(capacity) {
+    if (_engine == Engine::Bitmap) {
+        // power of two (for masking) and at least one full bitmap word
+        size_t ring_size = 64;
+        while (ring_size < capacity) {
+            ring_size <<= 1;
+        }
+        _ring.resize(ring_size);
+        _bitmap.resize(ring_size / 64);
+        _ring_mask = ring_size - 1;
+    }
 }
 
-void StreamReassembler::merge_seg(Seg &s1, const Seg &s2) const{
-    if (s1.l > s2.l) {
-        s1.data = s2.data.substr(0, (s1.l - 1) - s2.l + 1) + s1.data;
-        s1.l = s2.l;
+//! \details Only the left neighbour (the last interval starting at or before `index`) and the
+//! intervals starting inside the new range are examined, found with upper_bound. Intervals
+//! that the new range covers entirely are dropped; at the two ends the new range is trimmed
+//! instead, so each call inserts at most one node and never concatenates stored strings.
+//! What is stored is copied if it is small or trimmed at its end; otherwise it is kept by reference.
+void StreamReassembler::insert_segment(Buffer data, const uint64_t index) {
+    uint64_t l = max<uint64_t>(index, _first_unassembled);
+    uint64_t r = min<uint64_t>(index + data.size(), first_unacceptable());
+    if (l >= r) {
+        return;
+    }
+
+    auto it = _segments.upper_bound(l);
+    if (it != _segments.begin()) {
+        const auto prev = std::prev(it);
+        const uint64_t prev_end = prev->first + prev->second.size();
+        if (prev_end >= r) {
+            return;  // already held
+        }
+        l = max(l, prev_end);
     }
-    if (s1.r < s2.r) {
-        s1.data = s1.data + s2.data.substr(s1.r + 1 - s2.l);
-        s1.r = s2.r;
+    while (it != _segments.end() and it->first < r) {
+        const uint64_t it_end = it->first + it->second.size();
+        if (it_end > r) {
+            r = it->first;
+            break;
+        }
+        _unassembled_bytes -= it->second.size();
+        it = _segments.erase(it);
     }
+
+    data.remove_prefix(l - index);
+    if (r - l < ByteStream::COPY_BELOW) {
+        data = copy_small(data.str().substr(0, r - l));
+    } else if (data.size() > r - l) {
+        data = Buffer(string(data.str().substr(0, r - l)));
+    }
+    _unassembled_bytes += data.size();
+    _segments.emplace_hint(it, l, move(data));
 }
 
-void StreamReassembler::handle_overlap(Seg &seg) {
-    for (auto it = _st.begin(); it != _st.end();) {
-        auto nxt = ++it;
-        it--;
-        if (seg_overlap(*it, seg)) {
-            merge_seg(seg, *it);
-            _st.erase(it);
-        }
-        it = nxt;
+//! \details Small substrings share a slab, so a window full of them holds about one slab per
+//! Slab::CAPACITY bytes rather than one per substring.
+Buffer StreamReassembler::copy_small(const string_view data) {
+    if (not _tail or _tail.size() + data.size() > Slab::CAPACITY) {
+        _tail = Slab::allocate();
     }
-    _st.insert(seg);
+    const size_t start = _tail.size();
+    _tail.append(data);
+    Buffer copy{Slab{_tail}};
+    copy.remove_prefix(start);
+    return copy;
 }
 
-void StreamReassembler::set_assembled(ByteStream& stream) {
-    _unassembled_bytes = 0;
-    for (auto it = _st.begin(); it != _st.end();) {
-        auto nxt = ++it;
-        --it;
-        if ((*it).l == _first_unassembled) {
-            stream.write((*it).data);
-            _first_unassembled = (*it).r + 1;
-            _st.erase(it);
-        } else {
-            _unassembled_bytes += (*it).data.size();
+void StreamReassembler::assemble() {
+    while (not _segments.empty() and _segments.begin()->first == _first_unassembled) {
+        const Buffer &data = _segments.begin()->second;
+        _first_unassembled += _output.write(data);
+        _unassembled_bytes -= data.size();
+        _segments.erase(_segments.begin());
+    }
+}
+
+//! \details The window [first_unassembled(), first_unacceptable()) is never wider than the ring,
+//! so live stream indices never collide on a ring position.
+void StreamReassembler::insert_bits(string_view data, const uint64_t index) {
+    const uint64_t l = max<uint64_t>(index, _first_unassembled);
+    const uint64_t r = min<uint64_t>(index + data.size(), first_unacceptable());
+    if (l >= r) {
+        return;
+    }
+    const size_t start = l & _ring_mask;
+    const size_t len = r - l;
+    const size_t first = min(len, _ring.size() - start);
+    const char *src = data.data() + (l - index);
+    memcpy(_ring.data() + start, src, first);
+    memcpy(_ring.data(), src + first, len - first);
+    _unassembled_bytes += set_bits(start, start + first) + set_bits(0, len - first);
+}
+
+size_t StreamReassembler::set_bits(const size_t begin, const size_t end) {
+    size_t newly_set = 0;
+    for (size_t pos = begin; pos < end;) {
+        const size_t bit = pos % 64;
+        const size_t n = min<size_t>(64 - bit, end - pos);
+        const uint64_t mask = (n == 64 ? ~uint64_t{0} : (uint64_t{1} << n) - 1) << bit;
+        uint64_t &word = _bitmap[pos / 64];
+        newly_set += __builtin_popcountll(mask & ~word);
+        word |= mask;
+        pos += n;
+    }
+    return newly_set;
+}
+
+//! \details Scans a word at a time from the first unassembled position, clearing the bits it
+//! passes, then writes the run out of the ring in at most two pieces.
+void StreamReassembler::assemble_bits() {
+    const size_t start = _first_unassembled & _ring_mask;
+    size_t run = 0;
+    for (size_t pos = start; run < _ring.size();) {
+        const size_t bit = pos % 64;
+        uint64_t &word = _bitmap[pos / 64];
+        const size_t n = countr_one(word >> bit);
+        if (n == 0) {
+            break;
+        }
+        word &= ~((n == 64 ? ~uint64_t{0} : (uint64_t{1} << n) - 1) << bit);
+        run += n;
+        if (bit + n < 64) {
+            break;
         }
-        it = nxt;
+        pos = (pos + n) & _ring_mask;
+    }
+    if (run == 0) {
+        return;
     }
+    const size_t first = min(run, _ring.size() - start);
+    _output.write(string_view(_ring.data() + start, first));
+    _output.write(string_view(_ring.data(), run - first));
+    _first_unassembled += run;
+    _unassembled_bytes -= run;
 }
 
 void StreamReassembler::set_stream_end(ByteStream& stream) {
@@ -59,34 +159,76 @@ void StreamReassembler::set_stream_end(ByteStream& stream) {
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    // 中间出现空串的话会出错
-    ByteStream &stream = stream_out();
-    size_t end_iter = index + data.size();
     if (eof) {
-        _end_idx = end_iter;
+        _end_idx = index + data.size();
         _eof = true;
     }
-    set_stream_end(stream);
-
-    size_t l, r;
-    size_t first_unaccept = first_unacceptable();
-    if (index >= first_unaccept) return;
-    if (end_iter <= _first_unassembled) return;
-    r = min(end_iter - 1, first_unaccept - 1);
-    l = max(index, _first_unassembled);
-    assert(l <= r);
-    string _data = data.substr(l - index, r - l + 1); // (r-index)-(l-index)+1
-
-    Seg seg = {l, r,  index, _data};
-    handle_overlap(seg);
-    set_assembled(stream);
-    set_stream_end(stream);
+    if (_engine == Engine::Bitmap) {
+        insert_bits(data, index);
+        assemble_bits();
+    } else {
+        // copy only the part of `data` that fits in the window
+        const size_t l = max(index, _first_unassembled);
+        const size_t r = min(index + data.size(), first_unacceptable());
+        if (l < r) {
+            insert_segment(Buffer(data.substr(l - index, r - l)), l);
+        }
+        assemble();
+    }
+    set_stream_end(_output);
+}
+
+void StreamReassembler::push_substring(const Buffer &data, const size_t index, const bool eof) {
+    if (eof) {
+        _end_idx = index + data.size();
+        _eof = true;
+    }
+    if (_engine == Engine::Bitmap) {
+        insert_bits(data.str(), index);
+        assemble_bits();
+    } else {
+        insert_segment(data, index);
+        assemble();
+    }
+    set_stream_end(_output);
 }
 
 size_t StreamReassembler::unassembled_bytes() const {
     return _unassembled_bytes;
 }
 
+//! \details The bitmap engine skips empty bitmap words whole, so the cost is one step per run
+//! of held bytes plus one per 64 bytes of window.
+vector<pair<uint64_t, uint64_t>> StreamReassembler::held_intervals() const {
+    vector<pair<uint64_t, uint64_t>> intervals;
+    const auto add = [&intervals](const uint64_t begin, const uint64_t end) {
+        if (not intervals.empty() and intervals.back().second == begin) {
+            intervals.back().second = end;
+        } else {
+            intervals.emplace_back(begin, end);
+        }
+    };
+    if (_engine == Engine::Bitmap) {
+        for (uint64_t i = _first_unassembled; i < first_unacceptable();) {
+            const size_t pos = i & _ring_mask;
+            const uint64_t word = _bitmap[pos / 64] >> (pos % 64);
+            const size_t span = min<uint64_t>(64 - pos % 64, first_unacceptable() - i);
+            if (word & 1) {
+                const size_t n = min(countr_one(word), span);
+                add(i, i + n);
+                i += n;
+            } else {
+                i += word == 0 ? span : min<size_t>(__builtin_ctzll(word), span);
+            }
+        }
+    } else {
+        for (const auto &[index, data] : _segments) {
+            add(index, index + data.size());
+        }
+    }
+    return intervals;
+}
+
 bool StreamReassembler::empty() const {
     return unassembled_bytes() == 0;
-}
\ No newline at end of file
+}
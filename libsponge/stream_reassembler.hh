@@ -5,34 +5,71 @@
 
 #include <cstdint>
 #include <string>
-#include <set>
+#include <string_view>
 #include <map>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
-private:
-    struct Seg{
-        size_t l, r, index;
-        string data;
-        bool operator<(const Seg&seg) const{
-            return index < seg.index;
-        }
+public:
+    //! How out-of-order bytes are held until they can be assembled
+    enum class Engine {
+        IntervalMap,  //!< Ordered map of non-overlapping substrings; memory grows with what is stored
+        Bitmap        //!< Preallocated ring of `capacity` bytes plus one bit per byte; no allocation per push
     };
-    set<Seg>_st = {};
+
+private:
+    Engine _engine;
+    //! Stored substrings keyed by stream index. The intervals never overlap; adjacent
+    //! ones are kept as separate nodes and are only joined when written to the stream.
+    map<uint64_t, Buffer> _segments = {};
     bool _eof = false;
     size_t _unassembled_bytes = 0, _first_unassembled = 0, _end_idx = 0;
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
 
+    //! Slab that small stored substrings are copied into (see ByteStream::COPY_BELOW)
+    Slab _tail{};
+
+    //! Store the part of `data` (starting at `index`) that is inside the window and not already held
+    void insert_segment(Buffer data, const uint64_t index);
+
+    //! A copy of `data` in `_tail` (or in a fresh slab, if it is full)
+    Buffer copy_small(std::string_view data);
+
+    //! Write every stored substring that continues the assembled stream
+    void assemble();
+
+    //! \name Bitmap engine
+    //!@{
+    std::vector<char> _ring = {};        //!< The byte at stream index `i` lives at `_ring[i & _ring_mask]`
+    std::vector<uint64_t> _bitmap = {};  //!< Bit `i & _ring_mask` is set while that byte is held, unassembled
+    size_t _ring_mask = 0;
+
+    //! Copy the part of `data` that is inside the window into the ring and mark it held
+    void insert_bits(std::string_view data, const uint64_t index);
+
+    //! Set the bits for ring positions [begin, end) (no wrap); \returns how many were newly set
+    size_t set_bits(const size_t begin, const size_t end);
+
+    //! Write the run of held bytes that continues the assembled stream
+    void assemble_bits();
+    //!@}
+
+    void set_stream_end(ByteStream& stream);
+
 public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    StreamReassembler(const size_t capacity,
+                      const ByteStream::Storage storage = ByteStream::Storage::Ring,
+                      const Engine engine = Engine::IntervalMap);
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -44,6 +81,13 @@ public:
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer.
+    //!
+    //! Stored bytes are kept by reference, so a substring that needs no trimming at its end
+    //! reaches the output ByteStream without a copy (with ByteStream::Storage::Chunked).
+    //! Small substrings are copied instead, as ByteStream::write does.
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -57,20 +101,14 @@ public:
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief The ranges of stream indices held but not yet reassembled, as ascending, non-adjacent
+    //! [begin, end) pairs (e.g. for SACK blocks)
+    std::vector<std::pair<uint64_t, uint64_t>> held_intervals() const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
 
-    bool seg_overlap(const Seg &s1, const Seg &s2) const;
-
-    void merge_seg(Seg &s1, const Seg &s2) const;
-
-    void set_assembled(ByteStream& stream);
-
-    void handle_overlap(Seg &seg);
-
-    void set_stream_end(ByteStream& stream);
-
     size_t first_unacceptable() const{
         return _output.bytes_read() + _capacity;
     }
@@ -81,68 +119,3 @@ public:
 };
 
 #endif  // SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
-//#ifndef SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
-//#define SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
-//
-//#include "byte_stream.hh"
-//
-//#include <algorithm>
-//#include <cstdint>
-//#include <deque>
-//#include <iostream>
-//#include <string>
-//
-////! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
-////! possibly overlapping) into an in-order byte stream.
-//class StreamReassembler {
-//private:
-//    // Your code here -- add private members as necessary.
-//    size_t unass_base;        //!< The index of the first unassembled byte
-//    size_t unass_size;        //!< The number of bytes in the substrings stored but not yet reassembled
-//    bool _eof;                //!< The last byte has arrived
-//    std::deque<char> buffer;  //!< The unassembled strings
-//    std::deque<bool> bitmap;  //!< buffer bitmap
-//
-//    ByteStream _output;  //!< The reassembled in-order byte stream
-//    size_t _capacity;    //!< The maximum number of bytes
-//
-//    void check_contiguous();
-//    size_t real_size(const std::string &data, const size_t index);
-//
-//public:
-//    //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
-//    //! \note This capacity limits both the bytes that have been reassembled,
-//    //! and those that have not yet been reassembled.
-//    StreamReassembler(const size_t capacity);
-//
-//    //! \brief Receive a substring and write any newly contiguous bytes into the stream.
-//    //!
-//    //! The StreamReassembler will stay within the memory limits of the `capacity`.
-//    //! Bytes that would exceed the capacity are silently discarded.
-//    //!
-//    //! \param data the substring
-//    //! \param index indicates the index (place in sequence) of the first byte in `data`
-//    //! \param eof the last byte of `data` will be the last byte in the entire stream
-//    void push_substring(const std::string &data, const uint64_t index, const bool eof);
-//
-//    //! \name Access the reassembled byte stream
-//    //!@{
-//    const ByteStream &stream_out() const { return _output; }
-//    ByteStream &stream_out() { return _output; }
-//    //!@}
-//
-//    //! The number of bytes in the substrings stored but not yet reassembled
-//    //!
-//    //! \note If the byte at a particular index has been pushed more than once, it
-//    //! should only be counted once for the purpose of this function.
-//    size_t unassembled_bytes() const;
-//
-//    //! \brief Is the internal state empty (other than the output stream)?
-//    //! \returns `true` if no substrings are waiting to be assembled
-//    bool empty() const;
-//
-//    //! The acknowledge index of the stream, i.e., the index of the next interested substring
-//    size_t ack_index() const;
-//};
-//
-//#endif  // SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
\ No newline at end of file
@@ -3,7 +3,9 @@
  */
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 using namespace std;
 
@@ -49,9 +51,24 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     set_rst_state(false);
     return;
   }
+  // in order: it starts at the ackno and leaves nothing waiting for reassembly (before or after)
+  const bool expected = _receiver.ackno() == header.seqno && _receiver.unassembled_bytes() == 0;
   // gives the segment to the TCPReceiver so it can inspect the fields it cares about on
   // incoming segments: seqno, syn , payload, and fin
-  _receiver.segment_received(seg);
+  if (!_receiver.segment_received(seg)) {
+    // rejected by PAWS: acknowledge (unless it was a bare ACK, to avoid an ACK loop) and drop it
+    if (seg.length_in_sequence_space() > 0) {
+      _sender.send_empty_segment();
+      handle_sender_segments();
+    }
+    return;
+  }
+  if (header.syn && header.mss.has_value()) {
+    _sender.set_peer_mss(header.mss.value());
+  }
+  if (header.syn && _receiver.sack_permitted()) {
+    _sender.enable_sack();
+  }
 
   // 如果是 listen 到了 SYN,然后发出的时候因为有了ackno,所以会带上ACK
   if (TCPState::state_summary(_receiver) == TCPReceiverStateSummary::SYN_RECV &&
@@ -70,7 +87,22 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
   // tells the TCPSender about the fields it cares about
   // on incoming segments: ackno and window size
   if (header.ack) {
-    _sender.ack_received(header.ackno, header.win);
+    optional<size_t> echoed_rtt{};
+    if (_receiver.timestamps() && header.timestamps.has_value()) {
+      // only trust an echo of a TSval we could have sent: nonzero, not ahead of our clock (the unsigned
+      // difference would wrap), and no older than the longest we'd wait for an ACK. Anything else leaves
+      // the sender to time the ACK itself (Karn's rule).
+      const uint32_t tsecr = header.timestamps.value().tsecr;
+      const uint32_t age = static_cast<uint32_t>(_sender.time_ms()) - tsecr;
+      if (tsecr != 0 && age <= _cfg.max_rto) {
+        echoed_rtt = age;
+      }
+    }
+    if (!header.sack.empty()) {
+      _sender.sack_received(header.ackno, header.sack);
+    }
+    _sender.ack_received(
+        header.ackno, _receiver.peer_window(header), seg.length_in_sequence_space() == 0, echoed_rtt);
   }
   // 收到报文段后可能是 inbound end 和 outbound_ended_acked 条件满足
   if (check_inbound_ended() && check_outbound_ended_acked()) {
@@ -83,21 +115,69 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
   // sure that at least one segment is sent in reply,
   // to reflect an update in the ackno and window size.
   if (seg.length_in_sequence_space() > 0) {
-    _sender.send_empty_segment();
+    acknowledge(seg, expected && _receiver.unassembled_bytes() == 0);
   }
   handle_sender_segments();
 }
+
+//! \details With delayed ACKs ([RFC 1122](https://tools.ietf.org/html/rfc1122) 4.2.3.2, RFC 5681 4.2),
+//! in-order data is acknowledged once two full segments' worth has arrived or the delay runs out.
+//! A full segment is the largest payload the peer has sent, since its MSS may be smaller than ours.
+//! Out-of-order data (or data filling a hole), FIN and PSH are acknowledged at once, so the peer's
+//! loss recovery isn't slowed. Any segment we send carries the ACK, which cancels the pending one.
+void TCPConnection::acknowledge(const TCPSegment &seg, const bool in_order) {
+  if (_cfg.delayed_ack_timeout == 0) {
+    _sender.send_empty_segment();
+    return;
+  }
+  _unacknowledged_bytes += seg.payload().size();
+  _largest_payload = max(_largest_payload, seg.payload().size());
+  const bool ack_now =
+      !in_order || seg.header().fin || seg.header().psh || _unacknowledged_bytes >= 2 * _largest_payload;
+  if (ack_now) {
+    // outgoing data would carry the ACK anyway
+    if (_sender.segments_out().empty()) {
+      _sender.send_empty_segment();
+    }
+  } else if (!_delayed_ack_remaining.has_value()) {
+    _delayed_ack_remaining = _cfg.delayed_ack_timeout;
+  }
+}
 /**
  * 设置即将发送的报文段头部字段: ACK, ackno, win
+ * (and, on a SYN, the options describing what we accept: MSS, window scale and SACK; plus timestamps,
+ * and SACK blocks once data has arrived out of order)
  * @param segment
  */
 void TCPConnection::set_ack_win(TCPSegment &segment) {
+  TCPHeader &header = segment.header();
   optional<WrappingInt32> ackno = _receiver.ackno();
   if (ackno.has_value()) {
-    segment.header().ack = true;
-    segment.header().ackno = ackno.value();
+    header.ack = true;
+    header.ackno = ackno.value();
+    // this segment acknowledges everything received so far
+    _unacknowledged_bytes = 0;
+    _delayed_ack_remaining.reset();
+  }
+  header.win = _receiver.window_field(header.syn);
+  if (header.syn) {
+    header.mss = static_cast<uint16_t>(min<size_t>(_cfg.mss, numeric_limits<uint16_t>::max()));
+    // a SYN/ACK may only carry a window scale if the peer's SYN did (RFC 7323 2.2)
+    if (!ackno.has_value() || _receiver.window_scaling()) {
+      header.wscale = _receiver.window_shift_offer();
+    }
+    header.sack_permitted = _receiver.sack_offered() && (!ackno.has_value() || _receiver.sack_permitted());
+  } else {
+    header.sack = _receiver.sack_blocks();
+  }
+  // a SYN offers timestamps (a SYN/ACK only if the peer's SYN did); after the SYNs, every segment carries them
+  const bool timestamps = header.syn ? _receiver.timestamps_offered() && (!ackno.has_value() || _receiver.timestamps())
+                                     : _receiver.timestamps();
+  // TSval is the time as told by tick(), the same clock the sender's RTO runs on
+  if (timestamps) {
+    header.timestamps =
+        TCPHeader::Timestamps{static_cast<uint32_t>(_sender.time_ms()), _receiver.ts_recent().value_or(0)};
   }
-  segment.header().win = static_cast<uint16_t>(_receiver.window_size());
 }
 /**
  * Initiate a connection by sending a SYN segment
@@ -130,14 +210,26 @@ void TCPConnection::end_input_stream() {
   handle_sender_segments();
 }
 
+void TCPConnection::set_nagle(const bool nagle) {
+  _sender.set_nagle(nagle);
+  handle_sender_segments();
+}
+
+void TCPConnection::cork() { _sender.set_corked(true); }
+
+void TCPConnection::uncork() {
+  _sender.set_corked(false);
+  handle_sender_segments();
+}
+
 // prereq 1 : The inbound stream has been fully assembled and has ended.
-bool TCPConnection::check_inbound_ended() {
+bool TCPConnection::check_inbound_ended() const {
   return _receiver.unassembled_bytes() == 0 && _receiver.stream_out().input_ended();
 }
 // prereq 2 : The outbound stream has been ended by the local application and fully sent
 // (including the fact that it ended, i.e. a segment with fin ) to the remote peer.
 // prereq 3 : The outbound stream has been fully acknowledged by the remote peer.
-bool TCPConnection::check_outbound_ended_acked() {
+bool TCPConnection::check_outbound_ended_acked() const {
   return _sender.stream_in().eof() && _sender.next_seqno_absolute() == _sender.stream_in().bytes_written() + 2 &&
          _sender.bytes_in_flight() == 0;
 }
@@ -157,12 +249,16 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
     set_rst_state(true);
     return;
   }
-  // if new retransmit segment generated, send it
-  if (_sender.segments_out().size() > 0) {
-    TCPSegment retx_seg = _sender.segments_out().front();
-    _sender.segments_out().pop();
-    set_ack_win(retx_seg);
-    _segments_out.push(retx_seg);
+  // if new retransmit segments were generated, send them
+  handle_sender_segments();
+  // a delayed ACK whose time is up (unless a retransmission just carried it)
+  if (_delayed_ack_remaining.has_value()) {
+    if (_delayed_ack_remaining.value() <= ms_since_last_tick) {
+      _sender.send_empty_segment();
+      handle_sender_segments();
+    } else {
+      _delayed_ack_remaining.value() -= ms_since_last_tick;
+    }
   }
   // At any point where prerequisites #1 through #3 are satisfied, the connection is “done”
   // (and active() should return false) if linger after streams finish is false.
@@ -173,6 +269,24 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
   }
 }
 
+optional<size_t> TCPConnection::next_timeout() const {
+  if (!_active) {
+    return {};
+  }
+  optional<size_t> next = _sender.next_timeout();
+  const auto sooner = [&next](const size_t ms) { next = next.has_value() ? min(next.value(), ms) : ms; };
+  if (_delayed_ack_remaining.has_value()) {
+    sooner(_delayed_ack_remaining.value());
+  }
+  // lingering ends 10 * rt_timeout after the last segment arrived (and not lingering ends at once)
+  if (check_inbound_ended() && check_outbound_ended_acked()) {
+    const size_t linger = _linger_after_streams_finish ? 10 * _cfg.rt_timeout : 0;
+    const size_t since = _time_since_last_segment_received_counter;
+    sooner(linger > since ? linger - since : 0);
+  }
+  return next;
+}
+
 TCPConnection::~TCPConnection() {
   try {
     if (active()) {
@@ -123,8 +123,22 @@
 class TCPConnection {
 private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg.recv_capacity,
+                          _cfg.recv_storage,
+                          _cfg.recv_reassembler,
+                          _cfg.window_scaling,
+                          _cfg.timestamps,
+                          _cfg.sack};
+    TCPSender _sender{_cfg.send_capacity,
+                      _cfg.rt_timeout,
+                      _cfg.fixed_isn,
+                      _cfg.mss,
+                      _cfg.congestion_control,
+                      _cfg.adaptive_rto,
+                      _cfg.min_rto,
+                      _cfg.max_rto,
+                      _cfg.nagle,
+                      _cfg.pacing};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
@@ -136,18 +150,27 @@ private:
 
     size_t _time_since_last_segment_received_counter{0};
 
+    //! bytes received since we last sent an ACK (only counted with delayed ACKs)
+    size_t _unacknowledged_bytes{0};
+    //! the largest payload the peer has sent: its full-sized segment, which may be smaller than our MSS
+    size_t _largest_payload{0};
+    //! milliseconds until a delayed ACK must go out, if one is pending
+    std::optional<size_t> _delayed_ack_remaining{};
+
     bool _active{true};
 
     void set_rst_state(bool send_rst);
 
     bool handle_sender_segments();
     void set_ack_win(TCPSegment& segment);
+    //! A segment occupying sequence space arrived: ACK it now, or start (or advance) a delayed ACK
+    void acknowledge(const TCPSegment &seg, const bool in_order);
     // prereqs1 : The inbound stream has been fully assembled and has ended.
-    bool check_inbound_ended();
+    bool check_inbound_ended() const;
     // prereqs2 : The outbound stream has been ended by the local application and fully sent (including
     // the fact that it ended, i.e. a segment with fin ) to the remote peer.
     // prereqs3 : The outbound stream has been fully acknowledged by the remote peer.
-    bool check_outbound_ended_acked();
+    bool check_outbound_ended_acked() const;
 
 
 public:
@@ -166,6 +189,15 @@ public:
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Turn Nagle's algorithm on or off; off (like TCP_NODELAY) suits latency-sensitive flows
+    void set_nagle(const bool nagle);
+
+    //! \brief Like TCP_CORK: until uncork(), send only full-sized segments, however the data is written
+    void cork();
+
+    //! \brief Send whatever cork() held back
+    void uncork();
     //!@}
 
     //! \name "Output" interface for the reader
@@ -184,6 +216,15 @@ public:
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief the sender's smoothed round-trip time in milliseconds, once it has timed an ACK
+    std::optional<double> srtt() const { return _sender.srtt(); }
+    //! \brief the sender's current retransmission timeout in milliseconds
+    size_t rto() const { return _sender.rto(); }
+    //! \brief milliseconds until pacing releases the next segment (tick() the connection then), if one waits
+    std::optional<size_t> pacing_delay() const { return _sender.pacing_delay(); }
+    //! \brief milliseconds until tick() has something to do (retransmit, send a delayed ACK or paced
+    //! segment, or stop lingering), or empty if nothing will happen until a segment arrives
+    std::optional<size_t> next_timeout() const;
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
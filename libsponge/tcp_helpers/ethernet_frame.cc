@@ -17,8 +17,8 @@ ParseResult EthernetFrame::parse(const Buffer buffer) {
 }
 
 BufferList EthernetFrame::serialize() const {
-    BufferList ret;
-    ret.append(_header.serialize());
-    ret.append(_payload);
+    BufferList ret{_payload};
+    HeadroomWriter header_bytes{ret.prepend(EthernetHeader::LENGTH), EthernetHeader::LENGTH};
+    _header.serialize_into(header_bytes);
     return ret;
 }
@@ -28,10 +28,9 @@ ParseResult EthernetHeader::parse(NetParser &p) {
     return p.get_error();
 }
 
-string EthernetHeader::serialize() const {
-    string ret;
-    ret.reserve(LENGTH);
-
+//! Append the serialized EthernetHeader to `ret` (a std::string or HeadroomWriter)
+template <typename S>
+void EthernetHeader::serialize_into(S &ret) const {
     /* write destination address */
     for (auto &byte : dst) {
         NetUnparser::u8(ret, byte);
@@ -44,10 +43,18 @@ string EthernetHeader::serialize() const {
 
     /* write the frame's type (e.g. IPv4, ARP or something else) */
     NetUnparser::u16(ret, type);
+}
 
+//! Serialize the EthernetHeader to a string
+string EthernetHeader::serialize() const {
+    string ret;
+    ret.reserve(LENGTH);
+    serialize_into(ret);
     return ret;
 }
 
+template void EthernetHeader::serialize_into<HeadroomWriter>(HeadroomWriter &ret) const;
+
 //! \returns A string with a textual representation of an Ethernet address
 string to_string(const EthernetAddress address) {
     stringstream ss{};
@@ -33,6 +33,10 @@ struct EthernetHeader {
     //! Serialize the Ethernet fields to a string
     std::string serialize() const;
 
+    //! Append the serialized fields to `ret` (a std::string or HeadroomWriter)
+    template <typename S>
+    void serialize_into(S &ret) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 };
@@ -40,6 +40,9 @@ class FdAdapterBase {
 
     //! Called periodically when time elapses
     void tick(const size_t) {}
+
+    //! Milliseconds until tick() has something to do (never, here)
+    std::optional<size_t> next_timeout() const { return {}; }
 };
 
 //! \brief A FD adaptor that reads and writes TCP segments in UDP payloads
@@ -27,15 +27,20 @@ BufferList IPv4Datagram::serialize() const {
 
     IPv4Header header_out = _header;
     header_out.cksum = 0;
-    const string header_zero_checksum = header_out.serialize();
+    const size_t header_len = 4 * header_out.hlen;
+
+    BufferList ret{_payload};
+    char *const header_bytes = ret.prepend(header_len);
+    HeadroomWriter zero_checksum{header_bytes, header_len};
+    header_out.serialize_into(zero_checksum);
 
     // calculate checksum -- taken over header only
     InternetChecksum check;
-    check.add(header_zero_checksum);
+    check.add({header_bytes, header_len});
     header_out.cksum = check.value();
 
-    BufferList ret;
-    ret.append(header_out.serialize());
-    ret.append(_payload);
+    HeadroomWriter final_header{header_bytes, header_len};
+    header_out.serialize_into(final_header);
+
     return ret;
 }
@@ -74,8 +74,9 @@ ParseResult IPv4Header::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
-//! Serialize the IPv4Header to a string (does not recompute the checksum)
-string IPv4Header::serialize() const {
+//! Append the serialized IPv4Header to `ret` (a std::string or HeadroomWriter)
+template <typename S>
+void IPv4Header::serialize_into(S &ret) const {
     // sanity checks
     if (ver != 4) {
         throw runtime_error("wrong IP version");
@@ -84,8 +85,7 @@ string IPv4Header::serialize() const {
         throw runtime_error("IP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * hlen);
+    const size_t start = ret.size();
 
     const uint8_t first_byte = (ver << 4) | (hlen & 0xf);
     NetUnparser::u8(ret, first_byte);  // version and header length
@@ -104,11 +104,19 @@ string IPv4Header::serialize() const {
     NetUnparser::u32(ret, src);  // src address
     NetUnparser::u32(ret, dst);  // dst address
 
-    ret.resize(4 * hlen);  // expand header to advertised size
+    ret.resize(start + 4 * hlen);  // expand header to advertised size
+}
 
+//! Serialize the IPv4Header to a string (does not recompute the checksum)
+string IPv4Header::serialize() const {
+    string ret;
+    ret.reserve(4 * hlen);
+    serialize_into(ret);
     return ret;
 }
 
+template void IPv4Header::serialize_into<HeadroomWriter>(HeadroomWriter &ret) const;
+
 uint16_t IPv4Header::payload_length() const { return len - 4 * hlen; }
 
 //! \details This value is needed when computing the checksum of an encapsulated TCP segment.
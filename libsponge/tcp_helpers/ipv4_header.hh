@@ -52,6 +52,10 @@ struct IPv4Header {
     //! Serialize the IP fields
     std::string serialize() const;
 
+    //! Append the serialized fields to `ret` (a std::string or HeadroomWriter)
+    template <typename S>
+    void serialize_into(S &ret) const;
+
     //! Length of the payload
     uint16_t payload_length() const;
 
@@ -33,6 +33,9 @@ class LossyFdAdapter {
     //! Conversion to a FileDescriptor by returning the underlying AdapterT
     operator const FileDescriptor &() const { return _adapter; }
 
+    //! Conversion to a FileDescriptor by returning the underlying AdapterT
+    operator FileDescriptor &() { return _adapter; }
+
     //! Construct from a FileDescriptor appropriate to the AdapterT constructor
     explicit LossyFdAdapter(AdapterT &&adapter) : _adapter(std::move(adapter)) {}
 
@@ -66,6 +69,9 @@ class LossyFdAdapter {
     void tick(const size_t ms_since_last_tick) {
         _adapter.tick(ms_since_last_tick);
     }  //!< FdAdapterBase::tick passthrough
+    std::optional<size_t> next_timeout() const {
+        return _adapter.next_timeout();
+    }  //!< FdAdapterBase::next_timeout passthrough
     //!@}
 };
 
@@ -2,6 +2,9 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "stream_reassembler.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -15,10 +18,40 @@ class TCPConfig {
     static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr uint16_t MIN_RTO_DFLT = 200;      //!< Default lower bound on an adaptive RTO (as in Linux)
+    static constexpr uint32_t MAX_RTO_DFLT = 60000;    //!< Default upper bound on an adaptive RTO (RFC 6298)
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
+    //! Adapt the retransmission timeout to measured round-trip times (RFC 6298) instead of returning to
+    //! rt_timeout after every ACK
+    bool adaptive_rto = false;
+    uint16_t min_rto = MIN_RTO_DFLT;  //!< Lower bound on the adaptive retransmission timeout, in milliseconds
+    uint32_t max_rto = MAX_RTO_DFLT;  //!< Upper bound on the (adaptive, backed-off) timeout, in milliseconds
+    //! Delay acknowledgments by up to this many milliseconds, ACKing every second full segment instead of
+    //! every segment (0: acknowledge every segment at once)
+    uint16_t delayed_ack_timeout = 0;
+    //! Nagle's algorithm (RFC 896): while data is unacknowledged, hold back a segment smaller than the MSS
+    //! until more is written or the ACK arrives (false: like TCP_NODELAY, send small writes at once)
+    bool nagle = false;
+    //! Pace new segments at a rate derived from the window and the smoothed RTT, instead of sending the
+    //! whole window back to back
+    bool pacing = false;
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
+    //! Largest payload to send or accept, advertised in the MSS option (the peer's MSS may lower it)
+    size_t mss = MAX_PAYLOAD_SIZE;
+    //! Offer the RFC 7323 window scale option, so receive windows beyond 64 KiB can be advertised
+    bool window_scaling = true;
+    //! Offer the RFC 7323 timestamps option: an RTT sample from every ACK, and PAWS for the receiver
+    bool timestamps = true;
+    //! Offer RFC 2018 selective acknowledgments, so each side learns which later data the other holds
+    bool sack = true;
+    //! How the sender's congestion window responds to ACKs and losses (None: only the peer's window limits sending)
+    CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::None;
+    //! How the inbound stream stores bytes (Chunked keeps received payloads without copying them)
+    ByteStream::Storage recv_storage = ByteStream::Storage::Chunked;
+    //! How the receiver holds out-of-order bytes until they can be reassembled
+    StreamReassembler::Engine recv_reassembler = StreamReassembler::Engine::IntervalMap;
     std::optional<WrappingInt32> fixed_isn{};
 };
 
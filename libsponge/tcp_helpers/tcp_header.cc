@@ -1,9 +1,25 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
+namespace {
+
+//! \name TCP option kinds
+//!@{
+constexpr uint8_t OPT_EOL = 0;         //!< end of option list
+constexpr uint8_t OPT_NOP = 1;         //!< no-operation (padding)
+constexpr uint8_t OPT_MSS = 2;         //!< maximum segment size, 4 bytes
+constexpr uint8_t OPT_WSCALE = 3;      //!< window scale, 3 bytes
+constexpr uint8_t OPT_SACK_OK = 4;     //!< SACK permitted, 2 bytes
+constexpr uint8_t OPT_SACK = 5;        //!< SACK, 2 bytes plus 8 per block
+constexpr uint8_t OPT_TIMESTAMPS = 8;  //!< timestamps, 10 bytes
+//!@}
+
+}  // namespace
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -14,6 +30,9 @@ using namespace std;
 //! - the header's `doff` field is shorter than the minimum allowed
 //! - there is less data in the header than the `doff` field claims
 //! - the checksum is bad
+//!
+//! Options are parsed as far as the option list is well-formed; like most stacks, a malformed
+//! option ends the list rather than failing the segment.
 ParseResult TCPHeader::parse(NetParser &p) {
     sport = p.u16();                 // source port
     dport = p.u16();                 // destination port
@@ -37,8 +56,51 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    mss.reset();
+    wscale.reset();
+    timestamps.reset();
+    sack_permitted = false;
+    sack.clear();
+    size_t remaining = doff * 4 - TCPHeader::LENGTH;
+    while (remaining > 0 and not p.error()) {
+        const uint8_t kind = p.u8();
+        remaining--;
+        if (kind == OPT_EOL) {
+            break;
+        }
+        if (kind == OPT_NOP) {
+            continue;
+        }
+        if (remaining == 0) {
+            break;
+        }
+        const uint8_t len = p.u8();  // includes the kind and length bytes
+        remaining--;
+        if (len < 2 or len - 2u > remaining) {
+            break;
+        }
+        remaining -= len - 2;
+        if (kind == OPT_MSS and len == 4) {
+            mss = p.u16();
+        } else if (kind == OPT_WSCALE and len == 3) {
+            wscale = p.u8();
+        } else if (kind == OPT_SACK_OK and len == 2) {
+            sack_permitted = true;
+        } else if (kind == OPT_SACK and (len - 2) % 8 == 0) {
+            for (size_t i = 0; i < (len - 2u) / 8; i++) {
+                const WrappingInt32 left{p.u32()};
+                sack.push_back({left, WrappingInt32{p.u32()}});
+            }
+        } else if (kind == OPT_TIMESTAMPS and len == 10) {
+            const uint32_t tsval = p.u32();
+            timestamps = Timestamps{tsval, p.u32()};
+        } else {
+            p.remove_prefix(len - 2);
+        }
+    }
+
+    // skip the rest of the option list and any padding
+    p.remove_prefix(remaining);
 
     if (p.error()) {
         return p.get_error();
@@ -47,21 +109,21 @@ ParseResult TCPHeader::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
-//! Serialize the TCPHeader to a string (does not recompute the checksum)
-string TCPHeader::serialize() const {
+//! Append the serialized TCPHeader to `ret` (a std::string or HeadroomWriter)
+template <typename S>
+void TCPHeader::serialize_into(S &ret) const {
     // sanity check
     if (doff < 5) {
         throw runtime_error("TCP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * doff);
+    const size_t start = ret.size();
 
     NetUnparser::u16(ret, sport);              // source port
     NetUnparser::u16(ret, dport);              // destination port
     NetUnparser::u32(ret, seqno.raw_value());  // sequence number
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    NetUnparser::u8(ret, static_cast<uint8_t>(length() / 4) << 4);  // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
@@ -72,11 +134,73 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    if (mss.has_value()) {
+        NetUnparser::u8(ret, OPT_MSS);
+        NetUnparser::u8(ret, 4);
+        NetUnparser::u16(ret, mss.value());
+    }
+    if (wscale.has_value()) {
+        NetUnparser::u8(ret, OPT_NOP);  // keep the following options word-aligned
+        NetUnparser::u8(ret, OPT_WSCALE);
+        NetUnparser::u8(ret, 3);
+        NetUnparser::u8(ret, wscale.value());
+    }
+    if (sack_permitted) {
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_SACK_OK);
+        NetUnparser::u8(ret, 2);
+    }
+    if (timestamps.has_value()) {
+        NetUnparser::u8(ret, OPT_NOP);  // the layout recommended by RFC 7323 appendix A
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_TIMESTAMPS);
+        NetUnparser::u8(ret, 10);
+        NetUnparser::u32(ret, timestamps.value().tsval);
+        NetUnparser::u32(ret, timestamps.value().tsecr);
+    }
+    if (not sack.empty()) {
+        const size_t blocks = min(sack.size(), sack_capacity());
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_SACK);
+        NetUnparser::u8(ret, static_cast<uint8_t>(2 + 8 * blocks));
+        for (size_t i = 0; i < blocks; i++) {
+            NetUnparser::u32(ret, sack[i].left.raw_value());
+            NetUnparser::u32(ret, sack[i].right.raw_value());
+        }
+    }
+
+    ret.resize(start + length());  // pad (with end-of-list bytes) to the advertised size
+}
 
+//! \returns the length of every option but SACK, as serialized
+static size_t fixed_options_length(const TCPHeader &header) {
+    return (header.mss.has_value() ? 4 : 0) + (header.wscale.has_value() ? 4 : 0) + (header.sack_permitted ? 4 : 0) +
+           (header.timestamps.has_value() ? 12 : 0);
+}
+
+size_t TCPHeader::sack_capacity() const {
+    const size_t used = fixed_options_length(*this) + 4;  // plus two NOPs, kind and length
+    return used > MAX_OPTIONS_LENGTH ? 0 : min((MAX_OPTIONS_LENGTH - used) / 8, MAX_SACK_BLOCKS);
+}
+
+size_t TCPHeader::length() const {
+    const size_t sack_blocks = min(sack.size(), sack_capacity());
+    const size_t options = fixed_options_length(*this) + (sack_blocks > 0 ? 4 + 8 * sack_blocks : 0);
+    return max(4 * size_t{doff}, LENGTH + options);
+}
+
+//! Serialize the TCPHeader to a string (does not recompute the checksum)
+string TCPHeader::serialize() const {
+    string ret;
+    ret.reserve(length());
+    serialize_into(ret);
     return ret;
 }
 
+template void TCPHeader::serialize_into<HeadroomWriter>(HeadroomWriter &ret) const;
+
 //! \returns A string with the header's contents
 string TCPHeader::to_string() const {
     stringstream ss{};
@@ -90,6 +214,22 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (mss.has_value()) {
+        ss << "TCP MSS: " << dec << mss.value() << hex << '\n';
+    }
+    if (wscale.has_value()) {
+        ss << "TCP window scale: " << dec << +wscale.value() << hex << '\n';
+    }
+    if (timestamps.has_value()) {
+        ss << "TCP timestamps: " << dec << timestamps.value().tsval << " echo " << timestamps.value().tsecr << hex
+           << '\n';
+    }
+    if (sack_permitted) {
+        ss << "TCP SACK permitted\n";
+    }
+    for (const auto &block : sack) {
+        ss << "TCP SACK: " << dec << block.left << "-" << block.right << hex << '\n';
+    }
     return ss.str();
 }
 
@@ -104,5 +244,6 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && mss == other.mss && wscale == other.wscale &&
+           timestamps == other.timestamps && sack_permitted == other.sack_permitted && sack == other.sack;
 }
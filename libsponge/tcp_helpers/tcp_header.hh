@@ -4,10 +4,18 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <vector>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Of the TCP options, only MSS, window scale and timestamps ([RFC 7323](https://tools.ietf.org/html/rfc7323))
+//! and SACK ([RFC 2018](https://tools.ietf.org/html/rfc2018)) are understood; other options are skipped when
+//! parsing and dropped when serializing.
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr uint8_t MAX_WSCALE = 14;  //!< Largest window shift allowed by RFC 7323
+    static constexpr size_t MAX_OPTIONS_LENGTH = 40;  //!< Most option bytes a header can hold
+    static constexpr size_t MAX_SACK_BLOCKS = 4;      //!< Most SACK blocks that fit in the option space
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,12 +58,49 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! The timestamps option: the sender's clock, and the most recent timestamp it received from the peer
+    struct Timestamps {
+        uint32_t tsval = 0;  //!< timestamp value: the sender's clock when the segment was sent
+        uint32_t tsecr = 0;  //!< timestamp echo reply: the peer's TSval being echoed (meaningful only with ACK)
+
+        bool operator==(const Timestamps &other) const { return tsval == other.tsval and tsecr == other.tsecr; }
+        bool operator!=(const Timestamps &other) const { return not(*this == other); }
+    };
+
+    //! A SACK block: the peer holds the sequence numbers [left, right)
+    struct SackBlock {
+        WrappingInt32 left{0};   //!< first sequence number of the block
+        WrappingInt32 right{0};  //!< sequence number just past the block
+
+        bool operator==(const SackBlock &other) const { return left == other.left and right == other.right; }
+        bool operator!=(const SackBlock &other) const { return not(*this == other); }
+    };
+
+    //! \name TCP options (MSS, window scale and SACK-permitted are only meaningful on SYN segments)
+    //!@{
+    std::optional<uint16_t> mss{};           //!< maximum segment size: the largest payload the sender will accept
+    std::optional<uint8_t> wscale{};         //!< window scale: the shift the sender applies to its advertised windows
+    std::optional<Timestamps> timestamps{};  //!< timestamps, for RTT measurement and PAWS
+    bool sack_permitted = false;             //!< the sender can receive SACK blocks
+    std::vector<SackBlock> sack{};           //!< blocks received out of order (only sack_capacity() are sent)
+    //!@}
+
+    //! How many SACK blocks fit alongside the header's other options
+    size_t sack_capacity() const;
+
+    //! Length of the serialized header, options included: `doff` words, or more if the options need them
+    size_t length() const;
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
     //! Serialize the TCP fields
     std::string serialize() const;
 
+    //! Append the serialized fields to `ret` (a std::string or HeadroomWriter)
+    template <typename S>
+    void serialize_into(S &ret) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
@@ -0,0 +1,408 @@
+#include "tcp_mux.hh"
+
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+
+using namespace std;
+
+optional<pair<FourTuple, TCPSegment>> TunMuxLink::read() {
+    InternetDatagram ip_dgram;
+    if (ip_dgram.parse(_tun.read_buffer()) != ParseResult::NoError) {
+        return {};
+    }
+
+    // does the IPv4 datagram claim that its payload is a TCP segment?
+    if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
+        return {};
+    }
+
+    // is the payload a valid TCP segment?
+    TCPSegment seg;
+    if (seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum()) != ParseResult::NoError) {
+        return {};
+    }
+
+    const FourTuple tuple{ip_dgram.header().dst, seg.header().dport, ip_dgram.header().src, seg.header().sport};
+    return {{tuple, move(seg)}};
+}
+
+void TunMuxLink::write(const FourTuple &tuple, TCPSegment &seg) {
+    seg.header().sport = tuple.local_port;
+    seg.header().dport = tuple.remote_port;
+
+    InternetDatagram ip_dgram;
+    ip_dgram.header().src = tuple.local_ip;
+    ip_dgram.header().dst = tuple.remote_ip;
+    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().length() + as_const(seg).payload().size();
+    ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
+
+    _tun.write(ip_dgram.serialize());
+}
+
+UDPMuxLink::UDPMuxLink(UDPSocket &&sock)
+    : _sock(move(sock)), _local_ip(_sock.local_address().ipv4_numeric()), _local_port(_sock.local_address().port()) {}
+
+optional<pair<FourTuple, TCPSegment>> UDPMuxLink::read() {
+    auto datagram = _sock.recv();
+
+    // is the payload a valid TCP segment?
+    TCPSegment seg;
+    if (seg.parse(move(datagram.payload), 0) != ParseResult::NoError) {
+        return {};
+    }
+
+    const FourTuple tuple{
+        _local_ip, _local_port, datagram.source_address.ipv4_numeric(), datagram.source_address.port()};
+    return {{tuple, move(seg)}};
+}
+
+void UDPMuxLink::write(const FourTuple &tuple, TCPSegment &seg) {
+    seg.header().sport = tuple.local_port;
+    seg.header().dport = tuple.remote_port;
+
+    _sock.sendto({Address::from_ipv4_numeric(tuple.remote_ip).ip(), tuple.remote_port}, seg.serialize(0));
+}
+
+//! A SYN cookie is good for the time slot it was made in and the one after
+static constexpr uint64_t COOKIE_SLOT_MS = 64 * 1000;
+
+//! The MSS values a SYN cookie can remember, by the 3-bit index it carries (0: the SYN had no MSS option)
+static constexpr array<uint16_t, 8> COOKIE_MSS{0, 256, 536, 1000, 1200, 1300, 1440, 1460};
+
+//! The index of the largest COOKIE_MSS entry the peer's `mss` option allows (empty if it is below them all)
+static optional<uint32_t> cookie_mss_index(const optional<uint16_t> mss) {
+    if (not mss.has_value()) {
+        return 0;
+    }
+    for (uint32_t i = COOKIE_MSS.size() - 1; i > 0; i--) {
+        if (COOKIE_MSS[i] <= mss.value()) {
+            return i;
+        }
+    }
+    return {};
+}
+
+template <typename LinkT>
+TCPMux<LinkT>::TCPMux(LinkT &&link)
+    : _link(move(link))
+    , _cookie_key{}
+    , _timers(timestamp_ms()) {
+    random_device rd;
+    for (uint64_t &word : _cookie_key) {
+        word = (uint64_t{rd()} << 32) | rd();
+    }
+    _eventloop.add_rule(_link.fd(), Direction::In, [&] { segment_arrived(); });
+}
+
+//! \details A segment for a connection we know is handed to it. Otherwise, a SYN (without RST) for
+//! a listening port may create a connection, and an ACK returning a SYN cookie completes one;
+//! anything else is dropped.
+//!
+//! While a port's accept queue is full, segments for its connections still in the handshake are
+//! dropped, as Linux does: the handshake completes when the SYN/ACK is retransmitted and the peer
+//! acknowledges it again, by which time accept() may have made room.
+template <typename LinkT>
+void TCPMux<LinkT>::segment_arrived() {
+    run_timers();
+    auto incoming = _link.read();
+    if (not incoming.has_value()) {
+        return;
+    }
+    auto &[tuple, seg] = incoming.value();
+    const bool carries_data = seg.payload().size() > 0 or seg.header().fin;
+
+    auto it = _connections.find(tuple);
+    const auto listener = _listeners.find(tuple.local_port);
+    if (it == _connections.end()) {
+        if (listener == _listeners.end() or seg.header().rst) {
+            return;
+        }
+        if (seg.header().syn) {
+            it = syn_arrived(listener->second, tuple, seg);
+        } else if (seg.header().ack) {
+            it = cookie_returned(listener->second, tuple, seg);
+        }
+        if (it == _connections.end()) {
+            return;
+        }
+    }
+
+    const bool handshaking = listener != _listeners.end() and listener->second.syn_queue.count(tuple) > 0;
+    if (handshaking and not seg.header().rst and
+        listener->second.accept_queue.size() >= listener->second.limits.accept_backlog) {
+        return;
+    }
+
+    catch_up(it->second);
+    TCPConnection &conn = it->second.conn;
+    conn.segment_received(move(seg));
+    if (handshaking and conn.active() and conn.state() != TCPState::State::SYN_RCVD) {
+        listener->second.syn_queue.erase(tuple);
+        established(listener->second, tuple, conn);
+    }
+    // each handler may have written through TCPMux::write, which can already have removed it
+    if (it = _connections.find(tuple); it != _connections.end() and carries_data and _on_data) {
+        _on_data(tuple, it->second.conn);
+    }
+    if (it = _connections.find(tuple); it != _connections.end()) {
+        flush(it);
+    }
+}
+
+//! \details A SYN is dropped while the accept queue is full. While only the SYN queue is full, it is
+//! dropped too, unless SYN cookies are on: then the SYN/ACK is sent without keeping any state,
+//! its sequence number (the cookie) encoding a keyed hash of the FourTuple, the peer's ISN, the
+//! time and a class of the peer's MSS, so that the ACK returning it can be recognized by
+//! cookie_returned. (A SYN whose MSS is below every class is dropped.)
+template <typename LinkT>
+typename TCPMux<LinkT>::Connections::iterator TCPMux<LinkT>::syn_arrived(Listener &listener,
+                                                                        const FourTuple &tuple,
+                                                                        const TCPSegment &syn) {
+    if (listener.accept_queue.size() >= listener.limits.accept_backlog) {
+        return _connections.end();
+    }
+
+    if (listener.syn_queue.size() >= listener.limits.syn_backlog) {
+        const auto mss_index = cookie_mss_index(syn.header().mss);
+        if (listener.limits.syn_cookies and mss_index.has_value()) {
+            // only the MSS option: the connection cookie_returned makes won't remember any others
+            TCPSegment syn_ack;
+            syn_ack.header().syn = true;
+            syn_ack.header().ack = true;
+            syn_ack.header().seqno =
+                syn_cookie(tuple, syn.header().seqno, (_timers.now() / COOKIE_SLOT_MS) & 0xff, mss_index.value());
+            syn_ack.header().ackno = syn.header().seqno + 1;
+            syn_ack.header().win = min<size_t>(listener.cfg.recv_capacity, numeric_limits<uint16_t>::max());
+            syn_ack.header().mss = static_cast<uint16_t>(min<size_t>(listener.cfg.mss, numeric_limits<uint16_t>::max()));
+            _link.write(tuple, syn_ack);
+        }
+        return _connections.end();
+    }
+
+    listener.syn_queue.insert(tuple);
+    return _connections
+        .emplace(piecewise_construct, forward_as_tuple(tuple), forward_as_tuple(listener.cfg, timestamp_ms()))
+        .first;
+}
+
+//! \details The connection is rebuilt by replaying the SYN the cookie answered (with the MSS the
+//! cookie remembers, but without the other options or data it may have carried) into a new
+//! connection whose ISN is the cookie. It then joins the SYN queue, so the ACK itself completes its
+//! handshake as usual.
+template <typename LinkT>
+typename TCPMux<LinkT>::Connections::iterator TCPMux<LinkT>::cookie_returned(Listener &listener,
+                                                                            const FourTuple &tuple,
+                                                                            const TCPSegment &ack) {
+    if (not listener.limits.syn_cookies or listener.accept_queue.size() >= listener.limits.accept_backlog) {
+        return _connections.end();
+    }
+
+    const WrappingInt32 cookie = ack.header().ackno - 1;
+    const WrappingInt32 peer_isn = ack.header().seqno - 1;
+    const uint32_t slot = cookie.raw_value() >> 24;
+    const uint32_t mss_index = (cookie.raw_value() >> 21) & 0x7;
+    const uint32_t age = ((_timers.now() / COOKIE_SLOT_MS) - slot) & 0xff;
+    if (age > 1 or syn_cookie(tuple, peer_isn, slot, mss_index) != cookie) {
+        return _connections.end();
+    }
+
+    TCPConfig cfg = listener.cfg;
+    cfg.fixed_isn = cookie;
+    const auto it =
+        _connections.emplace(piecewise_construct, forward_as_tuple(tuple), forward_as_tuple(cfg, timestamp_ms()))
+            .first;
+    TCPConnection &conn = it->second.conn;
+
+    TCPSegment syn;
+    syn.header().syn = true;
+    syn.header().seqno = peer_isn;
+    syn.header().win = ack.header().win;
+    if (mss_index != 0) {
+        syn.header().mss = COOKIE_MSS[mss_index];
+    }
+    conn.segment_received(syn);
+    // its SYN/ACK went out with the cookie
+    while (not conn.segments_out().empty()) {
+        conn.segments_out().pop();
+    }
+
+    listener.syn_queue.insert(tuple);
+    return it;
+}
+
+//! \details The top 8 bits hold the time slot and the next 3 the MSS index; the low 21 bits are a
+//! SipHash, keyed by the secret, of those, the FourTuple and the peer's ISN (as Linux makes its cookies).
+template <typename LinkT>
+WrappingInt32 TCPMux<LinkT>::syn_cookie(const FourTuple &tuple,
+                                        const WrappingInt32 peer_isn,
+                                        const uint32_t slot,
+                                        const uint32_t mss_index) const {
+    const uint32_t tag = ((slot & 0xff) << 3) | (mss_index & 0x7);
+    const uint64_t mac = siphash(_cookie_key,
+                                 {(uint64_t{tuple.local_ip} << 32) | tuple.remote_ip,
+                                  (uint64_t{tuple.local_port} << 16) | tuple.remote_port,
+                                  (uint64_t{peer_isn.raw_value()} << 32) | tag});
+    return WrappingInt32{(tag << 21) | static_cast<uint32_t>(mac & 0x1fffff)};
+}
+
+template <typename LinkT>
+void TCPMux<LinkT>::established(Listener &listener, const FourTuple &tuple, TCPConnection &conn) {
+    if (_on_accept) {
+        _on_accept(tuple, conn);
+    } else {
+        listener.accept_queue.push_back(tuple);
+    }
+}
+
+template <typename LinkT>
+void TCPMux<LinkT>::flush(typename Connections::iterator it) {
+    auto &[tuple, entry] = *it;
+    TCPConnection &conn = entry.conn;
+    while (not conn.segments_out().empty()) {
+        _link.write(tuple, conn.segments_out().front());
+        conn.segments_out().pop();
+    }
+
+    if (entry.timer.has_value()) {
+        _timers.cancel(entry.timer.value());
+        entry.timer.reset();
+    }
+    if (conn.active()) {
+        // the deadlines count from the connection's last tick
+        if (const auto timeout = conn.next_timeout(); timeout.has_value()) {
+            entry.timer = _timers.schedule(entry.last_tick_ms + timeout.value(), tuple);
+        }
+        return;
+    }
+
+    if (_on_close) {
+        _on_close(tuple, conn);
+    }
+    if (const auto listener = _listeners.find(tuple.local_port); listener != _listeners.end()) {
+        auto &queue = listener->second.accept_queue;
+        listener->second.syn_queue.erase(tuple);
+        queue.erase(remove(queue.begin(), queue.end(), tuple), queue.end());
+    }
+    _connections.erase(it);
+}
+
+template <typename LinkT>
+void TCPMux<LinkT>::catch_up(Entry &entry) {
+    const uint64_t now = timestamp_ms();
+    if (now > entry.last_tick_ms) {
+        entry.conn.tick(now - entry.last_tick_ms);
+        entry.last_tick_ms = now;
+    }
+}
+
+//! \details A connection whose timer expires is told the time, which lets it act on whatever fell
+//! due, and its timer is set again for its next deadline (if it has one).
+template <typename LinkT>
+void TCPMux<LinkT>::run_timers() {
+    _timers.advance(timestamp_ms(), [&](const FourTuple &tuple) {
+        const auto it = _connections.find(tuple);
+        if (it == _connections.end()) {
+            return;
+        }
+        it->second.timer.reset();
+        catch_up(it->second);
+        flush(it);
+    });
+}
+
+template <typename LinkT>
+void TCPMux<LinkT>::listen(const uint16_t port, const TCPConfig &cfg, const TCPListenConfig &limits) {
+    // replacing a Listener would orphan its queued connections: never accepted, nor counted against the backlog
+    if (not _listeners.emplace(port, Listener{cfg, limits}).second) {
+        throw runtime_error("TCPMux: port is already listening");
+    }
+}
+
+template <typename LinkT>
+optional<FourTuple> TCPMux<LinkT>::accept(const uint16_t port) {
+    auto &queue = _listeners.at(port).accept_queue;
+    if (queue.empty()) {
+        return {};
+    }
+    const FourTuple tuple = queue.front();
+    queue.pop_front();
+    return tuple;
+}
+
+template <typename LinkT>
+TCPConnection &TCPMux<LinkT>::connect(const FourTuple &tuple, const TCPConfig &cfg) {
+    const auto [it, inserted] =
+        _connections.emplace(piecewise_construct, forward_as_tuple(tuple), forward_as_tuple(cfg, timestamp_ms()));
+    if (not inserted) {
+        throw runtime_error("TCPMux: connection is already in use");
+    }
+    it->second.conn.connect();
+    flush(it);
+    return it->second.conn;
+}
+
+template <typename LinkT>
+TCPConnection *TCPMux<LinkT>::find(const FourTuple &tuple) {
+    const auto it = _connections.find(tuple);
+    return it == _connections.end() ? nullptr : &it->second.conn;
+}
+
+template <typename LinkT>
+size_t TCPMux<LinkT>::write(const FourTuple &tuple, const string &data) {
+    const auto it = _connections.find(tuple);
+    if (it == _connections.end()) {
+        throw runtime_error("TCPMux: write to unknown connection");
+    }
+    catch_up(it->second);
+    const size_t written = it->second.conn.write(data);
+    flush(it);
+    return written;
+}
+
+template <typename LinkT>
+void TCPMux<LinkT>::end_input_stream(const FourTuple &tuple) {
+    const auto it = _connections.find(tuple);
+    if (it == _connections.end()) {
+        throw runtime_error("TCPMux: end_input_stream on unknown connection");
+    }
+    catch_up(it->second);
+    it->second.conn.end_input_stream();
+    flush(it);
+}
+
+template <typename LinkT>
+EventLoop::Result TCPMux<LinkT>::wait_next_event(const int timeout_ms) {
+    int timeout = timeout_ms;
+    if (const auto next = _timers.next_expiry(); next.has_value()) {
+        const uint64_t now = timestamp_ms();
+        const int until = next.value() > now ? static_cast<int>(next.value() - now) : 0;
+        timeout = timeout < 0 ? until : min(timeout, until);
+    }
+
+    const auto result = _eventloop.wait_next_event(timeout);
+    run_timers();
+    return result;
+}
+
+template <typename LinkT>
+void TCPMux<LinkT>::loop(const function<bool()> &condition) {
+    while (condition()) {
+        if (wait_next_event(-1) == EventLoop::Result::Exit) {
+            return;
+        }
+    }
+}
+
+//! Specialization of TCPMux for TunMuxLink
+template class TCPMux<TunMuxLink>;
+
+//! Specialization of TCPMux for UDPMuxLink
+template class TCPMux<UDPMuxLink>;
@@ -0,0 +1,245 @@
+#ifndef SPONGE_LIBSPONGE_TCP_MUX_HH
+#define SPONGE_LIBSPONGE_TCP_MUX_HH
+
+#include "eventloop.hh"
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "timer_wheel.hh"
+#include "tun.hh"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+//! \brief The addresses and ports naming one TCP connection, from this host's point of view
+struct FourTuple {
+    uint32_t local_ip{0};      //!< our IPv4 address (numeric, host byte order)
+    uint16_t local_port{0};    //!< our port
+    uint32_t remote_ip{0};     //!< the peer's IPv4 address
+    uint16_t remote_port{0};   //!< the peer's port
+
+    bool operator==(const FourTuple &other) const {
+        return local_ip == other.local_ip and local_port == other.local_port and remote_ip == other.remote_ip and
+               remote_port == other.remote_port;
+    }
+
+    //! Hash for use as an unordered_map key
+    struct Hash {
+        size_t operator()(const FourTuple &t) const {
+            const uint64_t ips = (uint64_t{t.local_ip} << 32) | t.remote_ip;
+            const uint64_t ports = (uint64_t{t.local_port} << 16) | t.remote_port;
+            return std::hash<uint64_t>{}(ips ^ (ports * 0x9e3779b97f4a7c15ULL));
+        }
+    };
+};
+
+//! \brief Limits on a listening port's half-open and not-yet-accepted connections
+struct TCPListenConfig {
+    size_t syn_backlog = 128;     //!< connections that have sent a SYN but not completed the handshake
+    size_t accept_backlog = 128;  //!< established connections waiting for TCPMux::accept
+    bool syn_cookies = false;     //!< when the SYN queue is full, answer SYNs statelessly with SYN cookies
+};
+
+//! \brief A link carrying TCP segments for many connections in IPv4 datagrams over a TUN device
+class TunMuxLink {
+  private:
+    TunFD _tun;
+
+  public:
+    //! Construct from a TunFD
+    explicit TunMuxLink(TunFD &&tun) : _tun(std::move(tun)) {}
+
+    //! Read a datagram, returning the TCP segment it carries and the connection it belongs to
+    //! (empty if it isn't a valid TCP segment)
+    std::optional<std::pair<FourTuple, TCPSegment>> read();
+
+    //! Wrap a segment of connection `tuple` in an IPv4 datagram and write it to the TUN device
+    void write(const FourTuple &tuple, TCPSegment &seg);
+
+    //! Access the underlying TUN device
+    FileDescriptor &fd() { return _tun; }
+};
+
+//! \brief A link carrying TCP segments for many connections in UDP payloads over one socket
+//! \details As with TCPOverUDPSocketAdapter, the UDP ports stand in for the TCP ports: a
+//! connection is named by the socket's local address and the address the datagrams come from.
+class UDPMuxLink {
+  private:
+    UDPSocket _sock;
+    uint32_t _local_ip;    //!< the socket's local address (0 if bound to INADDR_ANY)
+    uint16_t _local_port;  //!< the socket's local port
+
+  public:
+    //! Construct from a bound UDPSocket
+    explicit UDPMuxLink(UDPSocket &&sock);
+
+    //! Receive a datagram, returning the TCP segment it carries and the connection it belongs to
+    //! (empty if it isn't a valid TCP segment)
+    std::optional<std::pair<FourTuple, TCPSegment>> read();
+
+    //! Send a segment of connection `tuple` as a UDP payload to the peer's address
+    void write(const FourTuple &tuple, TCPSegment &seg);
+
+    //! Access the underlying UDP socket
+    FileDescriptor &fd() { return _sock; }
+};
+
+//! \brief Many TCPConnections sharing one link and one EventLoop
+//! \details Segments read from the link are demultiplexed by their FourTuple to the connection
+//! they belong to; a SYN for a listening port creates a new connection, within the port's
+//! TCPListenConfig (see TCPMux::listen). Each connection's segments are written to the link as soon
+//! as the event (or timer) that produced them has been handled, and connections that are no longer
+//! active are removed.
+//!
+//! Connections aren't ticked periodically. Each one with a deadline pending (see
+//! TCPConnection::next_timeout) has a timer in a TimerWheel shared by all of them, and is told the
+//! time only when that timer expires or a segment arrives for it. The EventLoop sleeps until the
+//! wheel's next expiry, so idle connections cost nothing.
+template <typename LinkT>
+class TCPMux {
+  public:
+    //! Called with a connection when something happens to it
+    using Handler = std::function<void(const FourTuple &, TCPConnection &)>;
+
+  private:
+    using Timers = TimerWheel<FourTuple>;
+
+    //! A connection, with its clock and its timer
+    struct Entry {
+        TCPConnection conn;                      //!< the connection
+        uint64_t last_tick_ms;                   //!< when it was last told the time
+        std::optional<Timers::TimerId> timer{};  //!< when it next needs to be told the time, if ever
+
+        Entry(const TCPConfig &cfg, const uint64_t now_ms) : conn(cfg), last_tick_ms(now_ms) {}
+    };
+    using Connections = std::unordered_map<FourTuple, Entry, FourTuple::Hash>;
+
+    //! A listening port
+    struct Listener {
+        TCPConfig cfg;                                               //!< configuration for its connections
+        TCPListenConfig limits;                                      //!< bounds on its queues
+        std::unordered_set<FourTuple, FourTuple::Hash> syn_queue{};  //!< connections in SYN_RCVD
+        std::deque<FourTuple> accept_queue{};                        //!< established, waiting for accept()
+    };
+
+    LinkT _link;                                          //!< the link all connections share
+    EventLoop _eventloop{};                               //!< waits for the link to be readable
+    Connections _connections{};                           //!< the connections, by FourTuple
+    std::unordered_map<uint16_t, Listener> _listeners{};  //!< listening ports
+    std::array<uint64_t, 2> _cookie_key;                  //!< keys the SYN cookies' hash
+    Timers _timers;                                       //!< every connection's next deadline
+
+    Handler _on_accept{};  //!< a connection has completed its handshake
+    Handler _on_data{};    //!< a connection's inbound stream has new bytes (or has ended)
+    Handler _on_close{};   //!< a connection is finished, and about to be removed
+
+    //! Read a segment from the link and hand it to its connection
+    void segment_arrived();
+
+    //! A SYN for `listener` from a new peer: the connection queued for it (or nothing, if the SYN was
+    //! answered with a SYN cookie or dropped)
+    typename Connections::iterator syn_arrived(Listener &listener, const FourTuple &tuple, const TCPSegment &syn);
+
+    //! An ACK for `listener` from an unknown peer: if it returns a valid SYN cookie, the connection it
+    //! completes (otherwise nothing)
+    typename Connections::iterator cookie_returned(Listener &listener, const FourTuple &tuple, const TCPSegment &ack);
+
+    //! The SYN cookie (our ISN) for a SYN from `tuple` with sequence number `peer_isn`, in time slot `slot`,
+    //! remembering the peer's MSS as `mss_index`
+    WrappingInt32 syn_cookie(const FourTuple &tuple,
+                             const WrappingInt32 peer_isn,
+                             const uint32_t slot,
+                             const uint32_t mss_index) const;
+
+    //! A connection of `listener` has completed its handshake: hand it to on_accept, or queue it
+    void established(Listener &listener, const FourTuple &tuple, TCPConnection &conn);
+
+    //! Write a connection's outgoing segments to the link, and remove it if it has finished (or
+    //! otherwise set its timer for its next deadline)
+    void flush(typename Connections::iterator it);
+
+    //! Tell a connection how much time has passed since it was last told
+    static void catch_up(Entry &entry);
+
+    //! Expire the timers that are due
+    void run_timers();
+
+  public:
+    //! Use `link` for the connections, which start out empty
+    explicit TCPMux(LinkT &&link);
+
+    //! \name Callbacks
+    //! Each is called with the connection concerned, whose segments are written out when it returns.
+    //! A handler may write to any connection, but must not open one with connect.
+    //!
+    //! If on_accept is set, it accepts every connection as its handshake completes; otherwise
+    //! established connections wait in their port's accept queue for accept().
+    //!@{
+    void on_accept(const Handler &handler) { _on_accept = handler; }
+    void on_data(const Handler &handler) { _on_data = handler; }
+    void on_close(const Handler &handler) { _on_close = handler; }
+    //!@}
+
+    //! Accept connections on local port `port`, each with configuration `cfg`, within the limits `limits`
+    //! \note Throws if `port` is already listening
+    void listen(const uint16_t port, const TCPConfig &cfg, const TCPListenConfig &limits = {});
+
+    //! Take the oldest established connection from `port`'s accept queue, if there is one
+    std::optional<FourTuple> accept(const uint16_t port);
+
+    //! The number of connections on `port` still in the handshake (not counting SYN cookies)
+    size_t syn_queue_size(const uint16_t port) const { return _listeners.at(port).syn_queue.size(); }
+
+    //! The number of established connections on `port` waiting for accept()
+    size_t accept_queue_size(const uint16_t port) const { return _listeners.at(port).accept_queue.size(); }
+
+    //! Open a connection named by `tuple` (which must not be in use) and send its SYN
+    TCPConnection &connect(const FourTuple &tuple, const TCPConfig &cfg);
+
+    //! The connection named by `tuple`, or nullptr if there isn't one
+    //! \note What is written to it directly goes out with its next event; write() sends at once.
+    TCPConnection *find(const FourTuple &tuple);
+
+    //! Write to a connection's outbound stream and send what the window allows
+    //! \returns the number of bytes accepted
+    size_t write(const FourTuple &tuple, const std::string &data);
+
+    //! End a connection's outbound stream
+    void end_input_stream(const FourTuple &tuple);
+
+    //! Wait up to `timeout_ms` (forever, if negative) for a segment, or until the next deadline of any
+    //! connection, and handle what arrives and what falls due
+    EventLoop::Result wait_next_event(const int timeout_ms);
+
+    //! Run wait_next_event (with no timeout) until `condition` returns false
+    void loop(const std::function<bool()> &condition);
+
+    //! The number of connections
+    size_t size() const { return _connections.size(); }
+
+    //! The number of connections with a deadline pending
+    size_t timers() const { return _timers.size(); }
+
+    //! Access the underlying link
+    LinkT &link() { return _link; }
+
+    //! \name
+    //! This object holds its own address in the EventLoop's callbacks, so it cannot be copied or moved
+    //!@{
+    TCPMux(const TCPMux &) = delete;
+    TCPMux &operator=(const TCPMux &) = delete;
+    //!@}
+};
+
+using TunTCPMux = TCPMux<TunMuxLink>;  //!< Connections over a TUN device
+using UDPTCPMux = TCPMux<UDPMuxLink>;  //!< Connections over a UDP socket
+
+#endif  // SPONGE_LIBSPONGE_TCP_MUX_HH
@@ -26,20 +26,36 @@ size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
+uint16_t TCPSegment::payload_sum() const {
+    if (not _payload_sum.has_value()) {
+        InternetChecksum check;
+        check.add(_payload);
+        _payload_sum = check.sum();
+    }
+    return _payload_sum.value();
+}
+
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+//! \details When the payload was read into a Slab with headroom, the header is written in place in front
+//! of it and the result is one contiguous Buffer (see BufferList::prepend).
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
     TCPHeader header_out = _header;
     header_out.cksum = 0;
+    const size_t header_len = header_out.length();
 
-    // calculate checksum -- taken over entire segment
-    InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
-    check.add(_payload);
+    BufferList ret{_payload};
+    char *const header_bytes = ret.prepend(header_len);
+    HeadroomWriter zero_checksum{header_bytes, header_len};
+    header_out.serialize_into(zero_checksum);
+
+    // calculate checksum -- taken over entire segment, but the payload's share is cached
+    // (the header's length is a multiple of 4, so the payload's words line up with the segment's)
+    InternetChecksum check(datagram_layer_checksum + payload_sum());
+    check.add({header_bytes, header_len});
     header_out.cksum = check.value();
 
-    BufferList ret;
-    ret.append(header_out.serialize());
-    ret.append(_payload);
+    HeadroomWriter final_header{header_bytes, header_len};
+    header_out.serialize_into(final_header);
 
     return ret;
 }
@@ -3,8 +3,9 @@
 
 #include "buffer.hh"
 #include "tcp_header.hh"
-#include <string>
 #include <cstdint>
+#include <optional>
+#include <string>
 
 using namespace std;
 
@@ -13,6 +14,7 @@ class TCPSegment {
   private:
     TCPHeader _header{};
     Buffer _payload{};
+    mutable std::optional<uint16_t> _payload_sum{};  //!< cached by payload_sum(), cleared by payload()
 
   public:
     //! \brief Parse the segment from a string
@@ -27,9 +29,19 @@ class TCPSegment {
     TCPHeader &header() { return _header; }
 
     const Buffer &payload() const { return _payload; }
-    Buffer &payload() { return _payload; }
+    //! \note Mutable access discards the cached payload_sum(); don't hold on to the reference
+    //! across a call to serialize().
+    Buffer &payload() {
+        _payload_sum.reset();
+        return _payload;
+    }
     //!@}
 
+    //! \brief Ones'-complement sum of the payload, computed on first use and then cached
+    //! \details The cached value travels with copies of the segment, so once it is computed (TCPSender does
+    //! so before queueing a segment), retransmissions only checksum the header and pseudo-header.
+    uint16_t payload_sum() const;
+
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
@@ -5,11 +5,14 @@
 #include "tun.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <cerrno>
 #include <cstddef>
 #include <exception>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -18,14 +21,41 @@
 
 using namespace std;
 
-static constexpr size_t TCP_TICK_MS = 10;
+//! The most inbound bytes written to the owner in one loop turn (and the size of the ring's buffers)
+static constexpr size_t INBOUND_WRITE_LIMIT = 65536;
+
+//! The ring's buffers (and queue entries): each posted datagram holds one until the next flush
+static constexpr size_t RING_BUFFERS = 32;
+
+//! The tag of the inbound write on the ring (the datagrams are posted, and need none)
+static constexpr uint64_t INBOUND_WRITE = 0;
 
 //! \param[in] condition is a function returning true if loop should continue
+//! \details Between events, the loop sleeps until the connection (or the adapter) next has a deadline
+//! to meet, and not at all while nothing is pending: an idle connection costs no wakeups.
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        // the deadlines count from the last tick, at base_time
+        int timeout = -1;
+        if (_tcp.value().active()) {
+            optional<size_t> deadline = _tcp.value().next_timeout();
+            if (const auto adapter = _datagram_adapter.next_timeout(); adapter.has_value()) {
+                deadline = min(deadline.value_or(adapter.value()), adapter.value());
+            }
+            if (deadline.has_value()) {
+                const size_t elapsed = timestamp_ms() - base_time;
+                timeout = deadline.value() > elapsed ? static_cast<int>(deadline.value() - elapsed) : 0;
+            }
+        }
+
+        // the last turn's writes, from the callbacks and the ticks, go to the kernel together
+        if (_ring.has_value()) {
+            _flush_ring();
+        }
+
+        auto ret = _eventloop.wait_next_event(timeout);
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
@@ -37,6 +67,69 @@ void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
             base_time = next_time;
         }
     }
+
+    if (_ring.has_value()) {
+        _flush_ring();
+    }
+}
+
+//! \details Where the kernel supports io_uring, the adapter's writes and the writes to the owner
+//! wait on a ring, and each loop turn hands them over together. Only the TCPConnection thread uses
+//! the ring, and closes it as it finishes (the handshake, on the owner's thread, makes a system call
+//! per write): closing a ring interrupts every thread that has used it.
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_open_ring() {
+    if (not IOUring::available()) {
+        return;
+    }
+    try {
+        _ring.emplace(RING_BUFFERS, RING_BUFFERS, INBOUND_WRITE_LIMIT);
+        _inbound_buffer = _ring->acquire_buffer().value();
+        static_cast<FileDescriptor &>(_datagram_adapter).set_write_ring(&_ring.value());
+    } catch (const unix_error &e) {
+        // e.g. the buffers exceed RLIMIT_MEMLOCK: make a system call per write instead
+        _ring.reset();
+    }
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_close_ring() {
+    if (_ring.has_value()) {
+        static_cast<FileDescriptor &>(_datagram_adapter).set_write_ring(nullptr);
+        _ring.reset();
+    }
+}
+
+//! \details The datagrams were posted, so the flush only reports the inbound write, if this turn made one
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_flush_ring() {
+    _ring->flush();
+    _completions.clear();
+    _ring->completions(_completions);
+    for (const auto &completion : _completions) {
+        // the owner's side may have filled up since the poll
+        if (completion.result < 0 and completion.result != -EAGAIN) {
+            throw unix_error("write", -completion.result);
+        }
+        _tcp->inbound_stream().consume(static_cast<size_t>(max(completion.result, 0)));
+        _inbound_written();
+    }
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_inbound_written() {
+    const ByteStream &inbound = _tcp->inbound_stream();
+    if (inbound.eof() or inbound.error()) {
+        _thread_data.shutdown(SHUT_WR);
+        _inbound_shutdown = true;
+
+        // debugging output:
+        cerr << "DEBUG: Inbound stream from " << _datagram_adapter.config().destination.to_string() << " finished "
+             << (inbound.error() ? "with an error/reset.\n" : "cleanly.\n");
+        if (_tcp.value().state() == TCPState::State::TIME_WAIT) {
+            cerr << "DEBUG: Waiting for lingering segments (e.g. retransmissions of FIN) from peer...\n";
+        }
+    }
 }
 
 //! \param[in] data_socket_pair is a pair of connected AF_UNIX SOCK_STREAM sockets
@@ -46,7 +139,8 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
                                          AdaptT &&datagram_interface)
     : LocalStreamSocket(move(data_socket_pair.first))
     , _thread_data(move(data_socket_pair.second))
-    , _datagram_adapter(move(datagram_interface)) {
+    , _datagram_adapter(move(datagram_interface))
+    , _wakeup(SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))) {
     _thread_data.set_blocking(false);
 }
 
@@ -125,25 +219,28 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         Direction::Out,
         [&] {
             ByteStream &inbound = _tcp->inbound_stream();
-            // Write from the inbound_stream into
-            // the pipe, handling the possibility of a partial
-            // write (i.e., only pop what was actually written).
-            const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
-            inbound.pop_output(bytes_written);
-
-            if (inbound.eof() or inbound.error()) {
-                _thread_data.shutdown(SHUT_WR);
-                _inbound_shutdown = true;
-
-                // debugging output:
-                cerr << "DEBUG: Inbound stream from " << _datagram_adapter.config().destination.to_string()
-                     << " finished " << (inbound.error() ? "with an error/reset.\n" : "cleanly.\n");
-                if (_tcp.value().state() == TCPState::State::TIME_WAIT) {
-                    cerr << "DEBUG: Waiting for lingering segments (e.g. retransmissions of FIN) from peer...\n";
+            const auto views = inbound.peek_views(INBOUND_WRITE_LIMIT);
+            if (_ring.has_value() and not views[0].empty()) {
+                // copied to the ring, to be written with the turn's datagrams (and consumed by _flush_ring)
+                char *out = _ring->buffer(_inbound_buffer);
+                out += views[0].copy(out, views[0].size());
+                views[1].copy(out, views[1].size());
+                // the ring has an entry per buffer, and this write holds its own
+                if (not _ring->write(
+                        _thread_data, _inbound_buffer, views[0].size() + views[1].size(), INBOUND_WRITE)) {
+                    throw runtime_error("TCPSpongeSocket: no room on the io_uring");
                 }
+                return;
             }
+
+            // Write from the inbound_stream into
+            // the pipe, handling the possibility of a partial
+            // write (i.e., only consume what was actually written).
+            // The bytes go straight from the stream's buffer to writev(), without a copy.
+            BufferViewList buffer{views[0]};
+            buffer.append(views[1]);
+            inbound.consume(_thread_data.write(buffer, false));
+            _inbound_written();
         },
         [&] {
             return (not _tcp->inbound_stream().buffer_empty()) or
@@ -160,6 +257,10 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                             }
                         },
                         [&] { return not _tcp->segments_out().empty(); });
+
+    // rule 5: the owner wants the loop to notice _abort (it may be sleeping with no deadline)
+    _eventloop.add_rule(
+        _wakeup, Direction::In, [&] { _wakeup.read(sizeof(uint64_t)); }, [&] { return _tcp->active(); });
 }
 
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
@@ -183,6 +284,8 @@ TCPSpongeSocket<AdaptT>::~TCPSpongeSocket() {
             cerr << "Warning: unclean shutdown of TCPSpongeSocket\n";
             // force the other side to exit
             _abort.store(true);
+            const uint64_t one = 1;
+            _wakeup.write(string(reinterpret_cast<const char *>(&one), sizeof(one)));
             _tcp_thread.join();
         }
     } catch (const exception &e) {
@@ -257,7 +360,9 @@ void TCPSpongeSocket<AdaptT>::_tcp_main() {
         if (not _tcp.has_value()) {
             throw runtime_error("no TCP");
         }
+        _open_ring();
         _tcp_loop([] { return true; });
+        _close_ring();
         shutdown(SHUT_RDWR);
         if (not _tcp.value().active()) {
             cerr << "DEBUG: TCP connection finished "
@@ -290,6 +395,7 @@ CS144TCPSocket::CS144TCPSocket() : TCPOverIPv4SpongeSocket(TCPOverIPv4OverTunFdA
 void CS144TCPSocket::connect(const Address &address) {
     TCPConfig tcp_config;
     tcp_config.rt_timeout = 100;
+    tcp_config.nagle = true;  // applications like webget write a line at a time
 
     FdAdapterConfig multiplexer_config;
     multiplexer_config.source = {"169.254.144.9", to_string(uint16_t(random_device()()))};
@@ -321,6 +427,7 @@ FullStackSocket::FullStackSocket()
 void FullStackSocket::connect(const Address &address) {
     TCPConfig tcp_config;
     tcp_config.rt_timeout = 100;
+    tcp_config.nagle = true;  // applications like webget write a line at a time
 
     FdAdapterConfig multiplexer_config;
     multiplexer_config.source = {LOCAL_TAP_IP_ADDRESS, to_string(uint16_t(random_device()()))};
@@ -5,6 +5,7 @@
 #include "eventloop.hh"
 #include "fd_adapter.hh"
 #include "file_descriptor.hh"
+#include "io_uring.hh"
 #include "network_interface.hh"
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
@@ -37,6 +38,28 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
     EventLoop _eventloop{};
 
+    //! \brief Where a loop turn's writes wait, if the kernel supports io_uring, to reach it in one
+    //! system call: the adapter's datagrams, and the inbound bytes for the owner
+    std::optional<IOUring> _ring{};
+
+    //! Set up the ring, if the kernel supports io_uring (on the TCPConnection thread)
+    void _open_ring();
+
+    //! Take the adapter's writes off the ring, and close it
+    void _close_ring();
+
+    //! The ring's buffer for the inbound bytes
+    size_t _inbound_buffer{0};
+
+    //! Completions collected by _flush_ring()
+    std::vector<IOUring::Completion> _completions{};
+
+    //! Hand the ring's writes to the kernel, and consume the inbound bytes it wrote
+    void _flush_ring();
+
+    //! After a write to the owner: shut down the inbound side if the stream has ended
+    void _inbound_written();
+
     //! Process events while specified condition is true
     void _tcp_loop(const std::function<bool()> &condition);
 
@@ -51,6 +74,8 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
     std::atomic_bool _abort{false};  //!< Flag used by the owner to force the TCPConnection thread to shut down
 
+    FileDescriptor _wakeup;  //!< [eventfd(2)](\ref man2::eventfd) the owner writes to wake the TCPConnection thread
+
     bool _inbound_shutdown{false};  //!< Has TCPSpongeSocket shut down the incoming data to the owner?
 
     bool _outbound_shutdown{false};  //!< Has the owner shut down the outbound data to the TCP connection?
@@ -117,7 +142,8 @@ using LossyTCPOverIPv4SpongeSocket = TCPSpongeSocket<LossyTCPOverIPv4OverTunFdAd
 //!
 //! There are a few notable differences between the TCPSpongeSocket and TCPSocket interfaces:
 //!
-//! - a TCPSpongeSocket can only accept a single connection
+//! - a TCPSpongeSocket can only accept a single connection (TCPMux::listen serves many, with
+//!   bounded SYN and accept queues)
 //! - listen_and_accept() is a blocking function call that acts as both [listen(2)](\ref man2::listen)
 //!   and [accept(2)](\ref man2::accept)
 //! - if TCPSpongeSocket is destructed while a TCP connection is open, the connection is
@@ -21,7 +21,7 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
     //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
     std::optional<TCPSegment> read() {
         InternetDatagram ip_dgram;
-        if (ip_dgram.parse(_tun.read()) != ParseResult::NoError) {
+        if (ip_dgram.parse(_tun.read_buffer()) != ParseResult::NoError) {
             return {};
         }
         return unwrap_tcp_in_ip(ip_dgram);
@@ -66,6 +66,9 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! Milliseconds until tick() has something to do (see NetworkInterface::next_timeout)
+    std::optional<size_t> next_timeout() const { return _interface.next_timeout(); }
+
     //! Access the underlying raw Ethernet connection
     operator TapFD &() { return _tap; }
 
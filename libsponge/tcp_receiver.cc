@@ -1,22 +1,48 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+#include <limits>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
 // automated checks run by `make check_lab2`.
 
 using namespace std;
+
+//! TSvals compare like sequence numbers: `a` is older than `b` if it is less than 2^31 behind it
+static bool ts_before(const uint32_t a, const uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+
 /**
  *  \brief 当前 TCPReceiver 大体上有三种状态， 分别是
  *      1. LISTEN，此时 SYN 包尚未抵达。可以通过 syn 标志位来判断是否在当前状态
  *      2. SYN_RECV, 此时 SYN 抵达。只能判断当前不在 1、3状态时才能确定在当前状态
  *      3. FIN_RECV, 此时 FIN 抵达。可以通过 ByteStream end_input 来判断是否在当前状态
  */
-void TCPReceiver::segment_received(const TCPSegment &seg) {
+bool TCPReceiver::segment_received(const TCPSegment &seg) {
     const TCPHeader &header = seg.header();
+    if (timestamps() and not header.rst) {
+        // PAWS: a TSval older than the newest one seen marks an old duplicate, perhaps from a
+        // previous trip around the sequence space
+        if (not header.timestamps.has_value() or ts_before(header.timestamps.value().tsval, _ts_recent.value())) {
+            return false;
+        }
+        // track the newest TSval of segments at or before the ackno we have been sending (RFC 7323 section 4.3),
+        // so a delayed, out-of-order segment can't push TS.Recent (and the echoed RTT) forward
+        if (header.seqno - ackno().value() <= 0) {
+            _ts_recent = header.timestamps.value().tsval;
+        }
+    }
     if (!syn && header.syn) {
         syn = true;
         ISN = header.seqno;
+        if (header.wscale.has_value()) {
+            _peer_window_shift = min(header.wscale.value(), TCPHeader::MAX_WSCALE);
+        }
+        if (_timestamps_offered and header.timestamps.has_value()) {
+            _ts_recent = header.timestamps.value().tsval;
+        }
+        _sack_permitted = _sack_offered and header.sack_permitted;
     }
     /*
      fix bug(add): && seg.length_in_sequence_space()
@@ -26,8 +52,12 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         uint64_t abs_seq = unwrap(header.seqno, ISN, _reassembler.first_unassembled());
         // SYN时求出来 abs_seq = 0, 没有steam_index,所以为了兼容reassembler, 给个0去
         uint64_t stream_index = abs_seq - 1 + (header.syn);
-        _reassembler.push_substring(seg.payload().copy(), stream_index, header.fin);
+        if (stream_index > _reassembler.first_unassembled()) {
+            _last_out_of_order = stream_index;
+        }
+        _reassembler.push_substring(seg.payload(), stream_index, header.fin);
     }
+    return true;
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
@@ -42,4 +72,39 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
 
 size_t TCPReceiver::window_size() const {
     return _reassembler.first_unacceptable() - _reassembler.first_unassembled();
-}
\ No newline at end of file
+}
+uint16_t TCPReceiver::window_field(const bool syn_segment) const {
+    const size_t shift = (window_scaling() and not syn_segment) ? _window_shift_offer.value() : 0;
+    return static_cast<uint16_t>(min<size_t>(window_size() >> shift, numeric_limits<uint16_t>::max()));
+}
+
+size_t TCPReceiver::peer_window(const TCPHeader &header) const {
+    const size_t shift = (window_scaling() and not header.syn) ? _peer_window_shift.value() : 0;
+    return size_t{header.win} << shift;
+}
+
+vector<TCPHeader::SackBlock> TCPReceiver::sack_blocks() const {
+    vector<TCPHeader::SackBlock> blocks;
+    if (not _sack_permitted or _reassembler.empty()) {
+        return blocks;
+    }
+    // stream index i is absolute sequence number i + 1
+    for (const auto &[begin, end] : _reassembler.held_intervals()) {
+        TCPHeader::SackBlock block{wrap(begin + 1, ISN), wrap(end + 1, ISN)};
+        if (_last_out_of_order.has_value() and begin <= _last_out_of_order.value() and
+            _last_out_of_order.value() < end) {
+            blocks.insert(blocks.begin(), block);
+        } else {
+            blocks.push_back(block);
+        }
+    }
+    return blocks;
+}
+
+uint8_t TCPReceiver::window_shift_for(const size_t capacity) {
+    uint8_t shift = 0;
+    while (shift < TCPHeader::MAX_WSCALE and (capacity >> shift) > numeric_limits<uint16_t>::max()) {
+        shift++;
+    }
+    return shift;
+}
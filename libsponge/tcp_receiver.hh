@@ -7,6 +7,7 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -24,12 +25,47 @@ class TCPReceiver {
     bool syn = false, fin = false;
     WrappingInt32 ISN{0};
 
+    //! the shift we offer in our SYN's window scale option, if window scaling is enabled
+    std::optional<uint8_t> _window_shift_offer;
+    //! the shift the peer offered in its SYN's window scale option
+    std::optional<uint8_t> _peer_window_shift{};
+
+    //! whether our SYN offers the timestamps option
+    bool _timestamps_offered;
+    //! TS.Recent: the timestamp to echo to the peer (set once both SYNs carried timestamps)
+    std::optional<uint32_t> _ts_recent{};
+
+    //! whether our SYN offers SACK
+    bool _sack_offered;
+    //! both SYNs carried SACK-permitted, so our ACKs may carry SACK blocks
+    bool _sack_permitted{false};
+    //! stream index of the most recent segment that arrived out of order (reported first, per RFC 2018)
+    std::optional<uint64_t> _last_out_of_order{};
+
+    //! the smallest shift that lets a window of `capacity` bytes fit in the 16-bit window field
+    static uint8_t window_shift_for(const size_t capacity);
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity) {}
+    //! \param storage how the inbound ByteStream holds its bytes
+    //! \param engine how the StreamReassembler holds out-of-order bytes
+    //! \param window_scaling whether to offer the [RFC 7323](https://tools.ietf.org/html/rfc7323) window scale option
+    //! \param timestamps whether to offer the RFC 7323 timestamps option
+    //! \param sack whether to offer [RFC 2018](https://tools.ietf.org/html/rfc2018) selective acknowledgments
+    TCPReceiver(const size_t capacity,
+                const ByteStream::Storage storage = ByteStream::Storage::Ring,
+                const StreamReassembler::Engine engine = StreamReassembler::Engine::IntervalMap,
+                const bool window_scaling = false,
+                const bool timestamps = false,
+                const bool sack = false)
+        : _reassembler(capacity, storage, engine)
+        , _capacity(capacity)
+        , _window_shift_offer(window_scaling ? std::optional<uint8_t>{window_shift_for(capacity)} : std::nullopt)
+        , _timestamps_offered(timestamps)
+        , _sack_offered(sack) {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -52,13 +88,48 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief The window field to send to the peer: window_size(), scaled down once both sides
+    //! have offered window scaling and clamped to 16 bits
+    //! \param syn whether the field goes on a SYN segment (whose window is never scaled)
+    uint16_t window_field(const bool syn) const;
+
+    //! \brief The shift to offer in the window scale option of our SYN (empty if not offering)
+    std::optional<uint8_t> window_shift_offer() const { return _window_shift_offer; }
+
+    //! \brief Both sides offered window scaling, so windows after the SYNs are scaled
+    bool window_scaling() const { return _window_shift_offer.has_value() and _peer_window_shift.has_value(); }
+
+    //! \brief The window, in bytes, advertised by a segment from the peer (scaled if negotiated)
+    size_t peer_window(const TCPHeader &header) const;
+
+    //! \brief Whether our SYN offers the timestamps option
+    bool timestamps_offered() const { return _timestamps_offered; }
+
+    //! \brief Both SYNs carried the timestamps option, so every segment after them carries it too
+    bool timestamps() const { return _ts_recent.has_value(); }
+
+    //! \brief The TSecr to send: the peer's most recent in-order TSval (empty unless timestamps() is true)
+    std::optional<uint32_t> ts_recent() const { return _ts_recent; }
+
+    //! \brief Whether our SYN offers SACK
+    bool sack_offered() const { return _sack_offered; }
+
+    //! \brief Both SYNs carried SACK-permitted
+    bool sack_permitted() const { return _sack_permitted; }
+
+    //! \brief SACK blocks describing the out-of-order data held (empty unless sack_permitted()):
+    //! first the block holding the latest out-of-order arrival, then the rest in sequence order
+    std::vector<TCPHeader::SackBlock> sack_blocks() const;
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
     //! \brief handle an inbound segment
-    void segment_received(const TCPSegment &seg);
+    //! \returns false if the segment was discarded without being looked at: once timestamps are in use,
+    //! PAWS (RFC 7323 section 5) rejects segments whose TSval is older than TS.Recent, or missing
+    bool segment_received(const TCPSegment &seg);
 
     //! \name "Output" interface for the reader
     //!@{
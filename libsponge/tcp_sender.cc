@@ -1,5 +1,9 @@
 #include "tcp_sender.hh"
 #include "tcp_config.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <random>
 
 template<typename... Targs>
@@ -7,16 +11,26 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn,
+                     const size_t mss, const CongestionControl::Algorithm congestion, const bool adaptive_rto,
+                     const uint16_t min_rto, const uint32_t max_rto, const bool nagle,
+                     const bool pacing)
         : _isn(fixed_isn.value_or(WrappingInt32{random_device()()})), _initial_retransmission_timeout{retx_timeout},
-          _stream(capacity), _ackno(0), _remote_win(1), _bytes_in_flight(0), timer(retx_timeout) {}
+          _stream(capacity), _mss(max<size_t>(mss, 1)),
+          _congestion(CongestionControl::make(congestion, _mss)), _nagle(nagle), _pacing(pacing), _ackno(0), _remote_win(1),
+          _bytes_in_flight(0), timer(retx_timeout, adaptive_rto, min_rto, max_rto) {}
 
 void TCPSender::send_segments(TCPSegment &seg) {
   seg.header().seqno = next_seqno();
+  // sum the payload once, before copying: retransmissions of the copy then only re-sum the header
+  seg.payload_sum();
+  _segments_outstanding.push_back({_next_seqno, seg, _time_ms});
   _next_seqno += seg.length_in_sequence_space();
   _bytes_in_flight += seg.length_in_sequence_space();
   _segments_out.push(seg);
-  _segments_outstanding.push(seg);
+  if (_pacing) {
+    pace(seg.length_in_sequence_space());
+  }
   // Every time a segment containing data (nonzero length in sequence space) is sent
   // (whether it’s the first time or a retransmission),
   // if the timer is not running, start it running
@@ -26,6 +40,11 @@ void TCPSender::send_segments(TCPSegment &seg) {
   }
 }
 
+void TCPSender::retransmit(Outstanding &out) {
+  out.retransmitted = true;
+  _segments_out.push(out.segment);
+}
+
 void TCPSender::fill_window() {
   // CLOSED -> stream waiting to begin
   if (!_syn_sent) {
@@ -42,14 +61,38 @@ void TCPSender::fill_window() {
   }
 
   size_t window_size = _remote_win == 0 ? 1 : _remote_win;
-  size_t remain = 0;
+  if (_congestion) {
+    if (_sack && _recovery_point.has_value()) {
+      retransmit_holes();
+    }
+    // the congestion window limits what is in the network, which SACKed segments have left
+    window_size = min(window_size, _congestion->cwnd() + (_next_seqno - _ackno) - pipe());
+  }
+  if (_retransmit_next.has_value()) {
+    retransmit_after_timeout(window_size);
+  }
+
+  // data that waited for its pacing slot keeps its schedule; otherwise a new one starts now
+  if (!_pacing_held) {
+    _pacing_next_ms = max(_pacing_next_ms, static_cast<double>(_time_ms));
+  }
+  _pacing_held = false;
 
-  while ((remain = window_size - (_next_seqno - _ackno))) {
+  // a window that shrank (e.g. rounded down by window scaling) may already be overfilled
+  while (window_size > _next_seqno - _ackno) {
+    if (_pacing && _pacing_next_ms > static_cast<double>(_time_ms)) {
+      _pacing_held = !_stream.buffer_empty() || (_stream.eof() && !_fin_sent);
+      return;
+    }
+    const size_t remain = window_size - (_next_seqno - _ackno);
     TCPSegment seg;
-    size_t len = TCPConfig::MAX_PAYLOAD_SIZE > remain ? remain : TCPConfig::MAX_PAYLOAD_SIZE;
+    size_t len = min(_mss, remain);
     // SYN_ACKED -> stream ongoing
     if (!_stream.eof()) {
-      seg.payload() = Buffer(_stream.read(len));
+      if (hold_small_segment(len)) {
+        return;
+      }
+      seg.payload() = _stream.read_with_headroom(len, Slab::PACKET_HEADROOM);
       if (_stream.eof() && remain - seg.length_in_sequence_space() > 0){
         seg.header().fin = true;
         _fin_sent = true;
@@ -73,48 +116,291 @@ void TCPSender::fill_window() {
   }
 }
 
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \details A segment shorter than `len` (the MSS, or what the window allows) is held back while corked,
+//! or with Nagle's algorithm while anything is unacknowledged; the next ACK or write sends it. It is
+//! never held once the stream has ended (the FIN goes out with it) or when the buffer is full, since
+//! the writer can't add to it then.
+bool TCPSender::hold_small_segment(const size_t len) const {
+  if (_stream.buffer_size() >= len || _stream.input_ended() || _stream.remaining_capacity() == 0) {
+    return false;
+  }
+  return _corked || (_nagle && _next_seqno > _ackno);
+}
+
+//! \details The rate is the window per smoothed RTT, scaled as in Linux: by 2 in slow start, so pacing
+//! doesn't hold back the window's growth, and by 1.2 otherwise. Without an RTT sample yet (or with a
+//! sub-millisecond one, which tick() can't resolve) segments go unpaced. Retransmissions are never paced.
+void TCPSender::pace(const size_t len) {
+  const optional<double> srtt = timer.srtt();
+  if (!srtt.has_value() || srtt.value() < 1) {
+    return;
+  }
+  size_t window = max<size_t>(_remote_win, _mss);
+  double gain = 1.2;
+  if (_congestion) {
+    window = min(window, _congestion->cwnd());
+    if (_congestion->cwnd() < _congestion->ssthresh()) {
+      gain = 2;
+    }
+  }
+  const double bytes_per_ms = gain * static_cast<double>(window) / srtt.value();
+  _pacing_next_ms += static_cast<double>(len) / bytes_per_ms;
+}
+
+optional<size_t> TCPSender::pacing_delay() const {
+  if (!_pacing_held) {
+    return {};
+  }
+  return static_cast<size_t>(ceil(_pacing_next_ms - static_cast<double>(_time_ms)));
+}
+
+optional<size_t> TCPSender::next_timeout() const {
+  const optional<size_t> rto = timer.remaining(), pacing = pacing_delay();
+  if (rto.has_value() && pacing.has_value()) {
+    return min(rto.value(), pacing.value());
+  }
+  return rto.has_value() ? rto : pacing;
+}
+
+void TCPSender::set_nagle(const bool nagle) {
+  _nagle = nagle;
+  // what Nagle was holding can go now (but don't let this send the SYN)
+  if (!nagle && _syn_sent) {
+    fill_window();
+  }
+}
+
+void TCPSender::set_corked(const bool corked) {
+  _corked = corked;
+  if (!corked && _syn_sent) {
+    fill_window();
+  }
+}
+
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const size_t window_size,
+                             const bool pure_ack,
+                             const optional<size_t> echoed_rtt) {
   uint64_t abs_ackno = unwrap(ackno, _isn, _ackno);
   // 确认还未发送的
   if (abs_ackno > _next_seqno) {
     return;
   }
-  _remote_win = static_cast<size_t>(window_size);
+  const bool window_changed = window_size != _remote_win;
+  _remote_win = window_size;
   // 已经被确认过
   if (abs_ackno <= _ackno) {
+    // RFC 5681: a duplicate ACK acknowledges nothing new, carries nothing, and leaves the window alone
+    if (abs_ackno == _ackno && pure_ack && !window_changed) {
+      duplicate_ack_received();
+    }
     return;
   }
+  // the SYN occupies a sequence number but carries no data, so it doesn't grow the congestion window
+  const size_t acked = abs_ackno - _ackno - (_ackno == 0 ? 1 : 0);
   _ackno = abs_ackno;
 
+  // compare absolute sequence numbers: the wrapped ones don't order across a wraparound
+  optional<uint64_t> sent_ms{};
+  bool ambiguous = false;
+  while (!_segments_outstanding.empty() && _segments_outstanding.front().end() <= abs_ackno) {
+    const Outstanding &out = _segments_outstanding.front();
+    // time the ACK by the newest segment it covers, unless any of them was retransmitted
+    ambiguous |= out.retransmitted;
+    sent_ms = out.sent_ms;
+    _bytes_in_flight -= out.segment.length_in_sequence_space();
+    _segments_outstanding.pop_front();
+  }
+  // a timestamp echo identifies the transmission being acknowledged, so it is good even after a retransmission
+  if (echoed_rtt.has_value()) {
+    timer.rtt_sample(echoed_rtt.value());
+  } else if (sent_ms.has_value() && !ambiguous) {
+    timer.rtt_sample(_time_ms - sent_ms.value());
+  }
+
   timer.init_rto();
   timer.start();
   _consecutive_retransmissions = 0;
+  if (_segments_outstanding.empty()) {
+    timer.shutdown();
+  }
+  if (_congestion) {
+    new_data_acked(acked);
+  }
+  fill_window();
+}
+
+void TCPSender::duplicate_ack_received() {
+  if (!_congestion || _segments_outstanding.empty()) {
+    return;
+  }
+  _duplicate_acks++;
+  if (_recovery_point.has_value()) {
+    // without SACK, each duplicate ACK stands for a segment that left the network; with it, pipe() counts them
+    if (!_sack) {
+      _congestion->on_duplicate_ack();
+    }
+    fill_window();
+  } else if (_duplicate_acks == 3 && _ackno >= _recover) {
+    // fast retransmit: the segment at the ackno was most likely lost
+    _congestion->on_fast_retransmit(_time_ms);
+    _recovery_point = _recover = _next_seqno;
+    retransmit(_segments_outstanding.front());
+    _hole_next = _segments_outstanding.front().end();
+    if (_sack) {
+      fill_window();
+    }
+  }
+}
+
+void TCPSender::sack_received(const WrappingInt32 ackno, const vector<TCPHeader::SackBlock> &blocks) {
+  if (!_sack) {
+    return;
+  }
+  const uint64_t abs_ackno = unwrap(ackno, _isn, _ackno);
+  for (const auto &block : blocks) {
+    const uint64_t left = unwrap(block.left, _isn, _ackno);
+    const uint64_t right = unwrap(block.right, _isn, _ackno);
+    // ignore D-SACKs (below the ackno) and blocks that don't describe anything we sent
+    if (left >= right || left < max(abs_ackno, _ackno) || right > _next_seqno) {
+      continue;
+    }
+    for (auto it = find_outstanding(left); it != _segments_outstanding.end() && it->end() <= right; ++it) {
+      if (it->seqno >= left) {
+        it->sacked = true;
+        _highest_sacked = max(_highest_sacked, it->end());
+      }
+    }
+  }
+}
+
+//! \details A hole is an un-SACKed segment below the highest SACKed one (RFC 6675's IsLost(), with
+//! a threshold of one SACKed segment above it). Holes are resent in order, once each per recovery,
+//! as far as the congestion window allows.
+void TCPSender::retransmit_holes() {
+  size_t in_network = pipe();
+  _hole_next = max(_hole_next, _ackno);
+  for (auto it = find_outstanding(_hole_next); it != _segments_outstanding.end() && it->end() <= _highest_sacked;
+       ++it) {
+    if (!it->sacked) {
+      const size_t len = it->segment.length_in_sequence_space();
+      if (in_network + len > _congestion->cwnd()) {
+        break;
+      }
+      retransmit(*it);
+      in_network += len;
+    }
+    _hole_next = it->end();
+  }
+}
+
+size_t TCPSender::pipe() const {
+  if (_highest_sacked <= _ackno) {
+    return _next_seqno - _ackno;
+  }
+  size_t in_network = 0;
+  for (const Outstanding &out : _segments_outstanding) {
+    const bool lost = _recovery_point.has_value() && out.seqno >= _hole_next && out.end() <= _highest_sacked;
+    if (!out.sacked && !lost) {
+      in_network += out.segment.length_in_sequence_space();
+    }
+  }
+  return in_network;
+}
 
-  while (!_segments_outstanding.empty()) {
-    TCPSegment seg = _segments_outstanding.front();
-    if (ackno.raw_value() >= seg.header().seqno.raw_value()
-                            + static_cast<uint32_t>(seg.length_in_sequence_space())){
-      _bytes_in_flight -= seg.length_in_sequence_space();
-      _segments_outstanding.pop();
-    }else{
+//! \details Go-back-N: everything outstanding at the timeout is presumed lost, and is resent
+//! (ahead of any new data) as the ACKs for the resent segments reopen the window.
+void TCPSender::retransmit_after_timeout(const size_t window_size) {
+  uint64_t &next = _retransmit_next.value();
+  next = max(next, _ackno);
+  while (next < _recover && next - _ackno < window_size) {
+    const auto it = find_outstanding(next);
+    if (it == _segments_outstanding.end()) {
       break;
     }
+    if (!it->sacked) {
+      retransmit(*it);
+    }
+    next = it->end();
   }
-  if (_segments_outstanding.empty()) {
-    timer.shutdown();
+  if (next >= _recover) {
+    _retransmit_next.reset();
+  }
+}
+
+void TCPSender::new_data_acked(const size_t acked) {
+  _duplicate_acks = 0;
+  if (!_recovery_point.has_value()) {
+    _congestion->on_ack(acked, _time_ms, timer.srtt());
+  } else if (_ackno >= _recovery_point.value()) {
+    _recovery_point.reset();
+    _congestion->on_recovery_exit();
+  } else {
+    // partial ACK (RFC 6582): the next hole was lost too, so retransmit it right away
+    // (with SACK, pipe() already accounts for it, so the window isn't deflated)
+    if (!_sack) {
+      _congestion->on_partial_ack(acked);
+      retransmit(_segments_outstanding.front());
+    } else if (_segments_outstanding.front().seqno >= _hole_next) {
+      retransmit(_segments_outstanding.front());
+      _hole_next = _segments_outstanding.front().end();
+    }
+  }
+}
+
+//! \details Only the SYN exchange can set the MSS: a duplicate SYN/ACK arriving once data has been sent
+//! is ignored, so it can't change the segment size (or the window) in the middle of a transfer.
+void TCPSender::set_peer_mss(const uint16_t mss) {
+  if (_next_seqno > 1) {
+    return;
+  }
+  _mss = min(_mss, max<size_t>(mss, 1));
+  if (_congestion) {
+    _congestion->set_mss(_mss);
   }
-  fill_window();
 }
 
 void TCPSender::tick(const size_t ms_since_last_tick) {
+  _time_ms += ms_since_last_tick;
   if (timer.expired(ms_since_last_tick)) {
     if (_remote_win > 0) {
       _consecutive_retransmissions++;
       timer.double_rto();
+      if (_congestion) {
+        _congestion->on_timeout(_time_ms);
+        _recovery_point.reset();
+        _duplicate_acks = 0;
+        _recover = _next_seqno;
+        _retransmit_next = _segments_outstanding.front().end();
+      }
     }
     timer.start();
-    _segments_out.push(_segments_outstanding.front());
+    retransmit(_segments_outstanding.front());
+    if (!_congestion && _sack) {
+      // with no congestion window to respect, resend every hole the scoreboard knows of at once
+      for (auto it = next(_segments_outstanding.begin());
+           it != _segments_outstanding.end() && it->end() <= _highest_sacked;
+           ++it) {
+        if (!it->sacked) {
+          retransmit(*it);
+        }
+      }
+    }
+  }
+  // release whatever became due since the last tick
+  if (_pacing_held) {
+    fill_window();
+  }
+}
+
+deque<TCPSender::Outstanding>::iterator TCPSender::find_outstanding(const uint64_t seqno) {
+  // first segment starting after seqno; the one before it is the only candidate
+  auto it = upper_bound(_segments_outstanding.begin(), _segments_outstanding.end(), seqno,
+                        [](const uint64_t value, const Outstanding &out) { return value < out.seqno; });
+  if (it == _segments_outstanding.begin() || prev(it)->end() <= seqno) {
+    return _segments_outstanding.end();
   }
+  return prev(it);
 }
 
 void TCPSender::send_empty_segment() {
@@ -415,7 +701,7 @@ void TCPSender::send_empty_segment() {
 // //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 // void TCPSender::tick(const size_t ms_since_last_tick) {
 //   if(_timer.expired(ms_since_last_tick)){
-//     _segments_out.push(_segments_outstanding.front());
+//     _segments_out.push(_segments_outstanding.front().segment);
 //     if (_receiver_window_size || _segments_outstanding.front().header().syn) {
 //       ++_consecutive_retransmissions;
 //       _timer.double_rto();
@@ -2,13 +2,17 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 #include "sender_timer.hh"
 
+#include <deque>
 #include <functional>
+#include <memory>
 #include <queue>
+#include <vector>
 #include <map>
 
 //! \brief The "sender" part of a TCP implementation.
@@ -34,6 +38,46 @@ private:
     //! the (absolute) sequence number for the next byte to be sent
     uint64_t _next_seqno{0};
 
+    //! largest payload to put in one segment: our configured MSS, lowered to the peer's if smaller
+    size_t _mss;
+
+    //! the congestion window's controller (nullptr if only the peer's window limits sending)
+    std::unique_ptr<CongestionControl> _congestion;
+    //! milliseconds since the sender was created, as told by tick()
+    uint64_t _time_ms{0};
+    //! duplicate ACKs received in a row
+    unsigned int _duplicate_acks{0};
+    //! during fast recovery, the (absolute) seqno whose acknowledgment ends it
+    std::optional<uint64_t> _recovery_point{};
+    //! _next_seqno when loss was last detected (RFC 6582 "recover"): duplicate ACKs below it don't
+    //! start another fast retransmit
+    uint64_t _recover{0};
+    //! after a timeout, the (absolute) seqno of the next outstanding segment to resend
+    std::optional<uint64_t> _retransmit_next{};
+
+    //! the peer sends SACK blocks
+    bool _sack{false};
+    //! (absolute) seqno just past the highest SACKed segment
+    uint64_t _highest_sacked{0};
+    //! during SACK recovery, the (absolute) seqno below which every hole has been resent
+    uint64_t _hole_next{0};
+
+    //! hold back small segments while data is unacknowledged (Nagle's algorithm)
+    bool _nagle;
+    //! hold back small segments unconditionally, until uncorked
+    bool _corked{false};
+    //! a segment of `len` bytes would be smaller than the writer will eventually fill: wait for more
+    bool hold_small_segment(const size_t len) const;
+
+    //! release new segments no faster than the pacing rate
+    bool _pacing;
+    //! when (in ms since the sender was created, with sub-millisecond precision) the next paced segment may go
+    double _pacing_next_ms{0};
+    //! the last fill_window() left data waiting for its pacing slot
+    bool _pacing_held{false};
+    //! schedule the slot after a `len`-byte segment, once there is an RTT to derive a rate from
+    void pace(const size_t len);
+
     //---- my code ----
     unsigned int _consecutive_retransmissions{0};
     bool _syn_sent = false;
@@ -43,8 +87,29 @@ private:
     size_t _remote_win;
     uint64_t _bytes_in_flight{0};
     TCPTimer timer;
-    std::queue<TCPSegment> _segments_outstanding{};
+
+    //! a segment that has been sent but not yet fully acknowledged
+    struct Outstanding {
+        uint64_t seqno;  //!< absolute sequence number of the segment's first byte
+        TCPSegment segment;
+        uint64_t sent_ms;            //!< when the segment was first sent
+        bool retransmitted{false};   //!< sent more than once, so its ACK can't be timed (Karn's rule)
+        bool sacked{false};          //!< the peer holds it (per a SACK block), so it never needs resending
+        uint64_t end() const { return seqno + segment.length_in_sequence_space(); }
+    };
+    //! in-flight segments, ordered by (absolute) sequence number
+    std::deque<Outstanding> _segments_outstanding{};
+    //! the outstanding segment containing (absolute) sequence number `seqno`, or end() if none does
+    std::deque<Outstanding>::iterator find_outstanding(const uint64_t seqno);
+
     void send_segments(TCPSegment &seg);
+    void retransmit(Outstanding &out);
+    void duplicate_ack_received();
+    void new_data_acked(const size_t acked);
+    void retransmit_after_timeout(const size_t window_size);
+    void retransmit_holes();
+    //! bytes still in the network: outstanding, less what was SACKed and (during recovery) the holes presumed lost
+    size_t pipe() const;
     //---- my code ----
 public:
     // ---- my code ----
@@ -54,7 +119,14 @@ public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE,
+              const CongestionControl::Algorithm congestion = CongestionControl::Algorithm::None,
+              const bool adaptive_rto = false,
+              const uint16_t min_rto = TCPConfig::MIN_RTO_DFLT,
+              const uint32_t max_rto = TCPConfig::MAX_RTO_DFLT,
+              const bool nagle = false,
+              const bool pacing = false);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -67,7 +139,29 @@ public:
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param window_size the peer's window in bytes (i.e. after any window scaling)
+    //! \param pure_ack the segment carried no data, SYN or FIN, so an unchanged ackno is a duplicate ACK
+    //! \param echoed_rtt the round-trip time measured by the segment's timestamp echo, if it had one
+    void ack_received(const WrappingInt32 ackno,
+                      const size_t window_size,
+                      const bool pure_ack = true,
+                      const std::optional<size_t> echoed_rtt = {});
+
+    //! \brief The peer's SYN carried an MSS option: never send payloads larger than `mss`
+    //! (ignored once anything beyond our SYN has been sent)
+    void set_peer_mss(const uint16_t mss);
+
+    //! \brief Both SYNs carried SACK-permitted: keep a scoreboard of SACKed segments and resend only the holes
+    void enable_sack() { _sack = true; }
+
+    //! \brief An ACK carried SACK blocks (call before ack_received() for the same segment)
+    void sack_received(const WrappingInt32 ackno, const std::vector<TCPHeader::SackBlock> &blocks);
+
+    //! \brief Turn Nagle's algorithm on or off (off sends whatever has been written right away)
+    void set_nagle(const bool nagle);
+
+    //! \brief While corked, only full-sized segments (and the FIN) are sent; uncorking sends the remainder
+    void set_corked(const bool corked);
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -87,6 +181,34 @@ public:
     //! (see TCPSegment::length_in_sequence_space())
     size_t bytes_in_flight() const { return _bytes_in_flight; };
 
+    //! \brief Largest payload the sender will put in one segment
+    size_t mss() const { return _mss; }
+
+    //! \brief Is Nagle's algorithm on?
+    bool nagle() const { return _nagle; }
+
+    //! \brief Is the sender corked?
+    bool corked() const { return _corked; }
+
+    //! \brief Milliseconds until pacing lets the next waiting segment go (empty if none is waiting)
+    std::optional<size_t> pacing_delay() const;
+
+    //! \brief Milliseconds until tick() has something to do: the retransmission timer expires or a
+    //! paced segment falls due (empty if neither is pending)
+    std::optional<size_t> next_timeout() const;
+
+    //! \brief The congestion controller, or nullptr if congestion control is off
+    const CongestionControl *congestion_control() const { return _congestion.get(); }
+
+    //! \brief The smoothed round-trip time in milliseconds, once an ACK has been timed
+    std::optional<double> srtt() const { return timer.srtt(); }
+
+    //! \brief The current retransmission timeout in milliseconds
+    size_t rto() const { return timer.rto(); }
+
+    //! \brief Milliseconds since the sender was created, as told by tick(): the clock RTTs are measured on
+    uint64_t time_ms() const { return _time_ms; }
+
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const { return _consecutive_retransmissions; };
 
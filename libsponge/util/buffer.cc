@@ -7,15 +7,52 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
+    if (_slab and _starting_offset == _slab_end) {
+        _slab = Slab{};
+        _starting_offset = _slab_end = 0;
+    }
     if (_storage and _starting_offset == _storage->size()) {
         _storage.reset();
     }
 }
 
+char *Buffer::claim_headroom(const size_t n) {
+    char *const bytes = _slab.claim_headroom(_starting_offset, n);
+    if (bytes) {
+        _starting_offset -= n;
+    }
+    return bytes;
+}
+
 void BufferList::append(const BufferList &other) {
     for (const auto &buf : other._buffers) {
         _buffers.push_back(buf);
     }
+    _size += other._size;
+}
+
+void BufferList::append(Buffer buffer) {
+    if (buffer.size() == 0) {
+        return;
+    }
+    _size += buffer.size();
+    _buffers.push_back(move(buffer));
+}
+
+char *BufferList::prepend(const size_t n) {
+    if (not _buffers.empty()) {
+        if (char *const bytes = _buffers.front().claim_headroom(n)) {
+            _size += n;
+            return bytes;
+        }
+    }
+
+    Slab header = Slab::allocate(Slab::PACKET_HEADROOM);
+    header.resize(n);
+    char *const bytes = header.data();
+    _buffers.push_front(Buffer{move(header)});
+    _size += n;
+    return bytes;
 }
 
 BufferList::operator Buffer() const {
@@ -40,15 +77,11 @@ string BufferList::concatenate() const {
     return ret;
 }
 
-size_t BufferList::size() const {
-    size_t ret = 0;
-    for (const auto &buf : _buffers) {
-        ret += buf.size();
-    }
-    return ret;
-}
-
 void BufferList::remove_prefix(size_t n) {
+    if (n > _size) {
+        throw std::out_of_range("BufferList::remove_prefix");
+    }
+    _size -= n;
     while (n > 0) {
         if (_buffers.empty()) {
             throw std::out_of_range("BufferList::remove_prefix");
@@ -66,39 +99,33 @@ void BufferList::remove_prefix(size_t n) {
 
 BufferViewList::BufferViewList(const BufferList &buffers) {
     for (const auto &x : buffers.buffers()) {
-        _views.push_back(x);
+        append(x);
+    }
+}
+
+void BufferViewList::append(string_view str) {
+    if (not str.empty()) {
+        _views.push_back({const_cast<char *>(str.data()), str.size()});
+        _size += str.size();
     }
 }
 
 void BufferViewList::remove_prefix(size_t n) {
+    if (n > _size) {
+        throw std::out_of_range("BufferListView::remove_prefix");
+    }
+    _size -= n;
     while (n > 0) {
-        if (_views.empty()) {
-            throw std::out_of_range("BufferListView::remove_prefix");
-        }
-
-        if (n < _views.front().size()) {
-            _views.front().remove_prefix(n);
+        iovec &front = _views.front();
+        if (n < front.iov_len) {
+            front.iov_base = static_cast<char *>(front.iov_base) + n;
+            front.iov_len -= n;
             n = 0;
         } else {
-            n -= _views.front().size();
+            n -= front.iov_len;
             _views.pop_front();
         }
     }
 }
 
-size_t BufferViewList::size() const {
-    size_t ret = 0;
-    for (const auto &buf : _views) {
-        ret += buf.size();
-    }
-    return ret;
-}
-
-vector<iovec> BufferViewList::as_iovecs() const {
-    vector<iovec> ret;
-    ret.reserve(_views.size());
-    for (const auto &x : _views) {
-        ret.push_back({const_cast<char *>(x.data()), x.size()});
-    }
-    return ret;
-}
+vector<iovec> BufferViewList::as_iovecs() const { return {_views.begin(), _views.end()}; }
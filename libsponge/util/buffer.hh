@@ -1,21 +1,28 @@
 #ifndef SPONGE_LIBSPONGE_BUFFER_HH
 #define SPONGE_LIBSPONGE_BUFFER_HH
 
+#include "slab.hh"
+#include "small_queue.hh"
+
 #include <algorithm>
-#include <deque>
 #include <memory>
 #include <numeric>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <sys/uio.h>
+#include <utility>
 #include <vector>
 
 //! \brief A reference-counted read-only string that can discard bytes from the front
+//! \note Backed either by a heap std::string or by a pooled Slab; the latter is what the
+//! segment pipeline uses for headers and received datagrams, so it does not hit the allocator.
 class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
-    size_t _starting_offset{};
+    Slab _slab{};
+    size_t _starting_offset{};  //!< into the string, or into the Slab's block
+    size_t _slab_end{};         //!< one past the last byte viewed, when backed by a Slab
 
   public:
     Buffer() = default;
@@ -23,9 +30,18 @@ class Buffer {
     //! \brief Construct by taking ownership of a string
     Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
 
+    //! \brief Construct by taking a reference to a filled-in Slab
+    Buffer(Slab &&slab) noexcept
+        : _slab(std::move(slab))
+        , _starting_offset(_slab ? _slab._header->head : 0)
+        , _slab_end(_slab ? _slab._header->length : 0) {}
+
     //! \name Expose contents as a std::string_view
     //!@{
     std::string_view str() const {
+        if (_slab) {
+            return {_slab.bytes() + _starting_offset, _slab_end - _starting_offset};
+        }
         if (not _storage) {
             return {};
         }
@@ -47,6 +63,13 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Extend the view backwards over `n` bytes of its Slab's headroom, to be filled in by the caller
+    //! \returns the first of the `n` bytes, or nullptr if the Buffer is not Slab-backed, has too little
+    //! headroom, or does not start at the Slab's first claimed byte (so someone else may be using the bytes
+    //! in front of it, e.g. an earlier transmission of the same payload)
+    //! \note Not thread-safe: a Slab's headroom must only be claimed from one thread.
+    char *claim_headroom(const size_t n);
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -54,18 +77,42 @@ class Buffer {
 //! + a payload. This allows us to prepend headers (e.g., to
 //! encapsulate a TCP payload in a TCPSegment, and then encapsulate
 //! the TCPSegment in an IPv4Datagram) without copying the payload.
+//! \note Packets carry a handful of Buffers (headers + payload), so they are kept inline and the
+//! total size is cached rather than recomputed on every size() call.
 class BufferList {
+  public:
+    //! Enough inline slots for an Ethernet frame holding an IPv4 datagram holding a TCP segment
+    static constexpr size_t INLINE_BUFFERS = 4;
+    using Queue = SmallQueue<Buffer, INLINE_BUFFERS>;
+
   private:
-    std::deque<Buffer> _buffers{};
+    Queue _buffers{};
+    size_t _size{};
 
   public:
     //! \name Constructors
     //!@{
 
     BufferList() = default;
+    BufferList(const BufferList &other) = default;
+    BufferList &operator=(const BufferList &other) = default;
+    ~BufferList() = default;
+
+    //! \brief Moving leaves `other` empty, its cached size included
+    BufferList(BufferList &&other) noexcept
+        : _buffers(std::move(other._buffers)), _size(std::exchange(other._size, 0)) {}
+
+    //! \brief Moving leaves `other` empty, its cached size included
+    BufferList &operator=(BufferList &&other) noexcept {
+        if (this != &other) {
+            _buffers = std::move(other._buffers);
+            _size = std::exchange(other._size, 0);
+        }
+        return *this;
+    }
 
     //! \brief Construct from a Buffer
-    BufferList(Buffer buffer) : _buffers{buffer} {}
+    BufferList(Buffer buffer) { append(std::move(buffer)); }
 
     //! \brief Construct by taking ownership of a std::string
     BufferList(std::string &&str) noexcept {
@@ -75,11 +122,17 @@ class BufferList {
     //!@}
 
     //! \brief Access the underlying queue of Buffers
-    const std::deque<Buffer> &buffers() const { return _buffers; }
+    const Queue &buffers() const { return _buffers; }
 
     //! \brief Append a BufferList
     void append(const BufferList &other);
 
+    //! \brief Append a single Buffer (empty Buffers are skipped)
+    void append(Buffer buffer);
+
+    //! \brief Append a std::string, taking ownership of it
+    void append(std::string &&str) { append(Buffer{std::move(str)}); }
+
     //! \brief Transform to a Buffer
     //! \note Throws an exception unless BufferList is contiguous
     operator Buffer() const;
@@ -88,15 +141,24 @@ class BufferList {
     void remove_prefix(size_t n);
 
     //! \brief Size of the string
-    size_t size() const;
+    size_t size() const { return _size; }
+
+    //! \brief Make room for an `n`-byte header in front of the list, to be filled in by the caller
+    //! \details Uses the first Buffer's headroom when it can be claimed, so the header lands in place;
+    //! otherwise the header gets a pooled Buffer of its own, with headroom for the next layer down.
+    //! \returns the first of the `n` bytes
+    char *prepend(const size_t n);
 
     //! \brief Make a copy to a new std::string
     std::string concatenate() const;
 };
 
 //! \brief A non-owning temporary view (similar to std::string_view) of a discontiguous string
+//! \note The views are stored directly as `iovec`s, so the list can be handed to
+//! [writev(2)](\ref man2::writev) or [sendmsg(2)](\ref man2::sendmsg) as-is, with no per-call allocation.
 class BufferViewList {
-    std::deque<std::string_view> _views{};
+    SmallQueue<iovec, BufferList::INLINE_BUFFERS> _views{};
+    size_t _size{};
 
   public:
     //! \name Constructors
@@ -112,18 +174,45 @@ class BufferViewList {
     BufferViewList(const BufferList &buffers);
 
     //! \brief Construct from a std::string_view
-    BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
+    BufferViewList(std::string_view str) { append(str); }
+
+    BufferViewList(const BufferViewList &other) = default;
+    BufferViewList &operator=(const BufferViewList &other) = default;
+    ~BufferViewList() = default;
+
+    //! \brief Moving leaves `other` empty, its cached size included
+    BufferViewList(BufferViewList &&other) noexcept
+        : _views(std::move(other._views)), _size(std::exchange(other._size, 0)) {}
+
+    //! \brief Moving leaves `other` empty, its cached size included
+    BufferViewList &operator=(BufferViewList &&other) noexcept {
+        if (this != &other) {
+            _views = std::move(other._views);
+            _size = std::exchange(other._size, 0);
+        }
+        return *this;
+    }
     //!@}
 
+    //! \brief Append a std::string_view (empty views are skipped)
+    void append(std::string_view str);
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     void remove_prefix(size_t n);
 
     //! \brief Size of the string
-    size_t size() const;
+    size_t size() const { return _size; }
 
-    //! \brief Convert to a vector of `iovec` structures
+    //! \name Expose the views as an array of `iovec` structures
     //! \note used for system calls that write discontiguous buffers,
-    //! e.g. [writev(2)](\ref man2::writev) and [sendmsg(2)](\ref man2::sendmsg)
+    //! e.g. [writev(2)](\ref man2::writev) and [sendmsg(2)](\ref man2::sendmsg).
+    //! The array is only valid until the list is next modified.
+    //!@{
+    const iovec *iovecs() const { return _views.data(); }
+    size_t iovec_count() const { return _views.size(); }
+    //!@}
+
+    //! \brief Convert to a vector of `iovec` structures (copies; prefer iovecs() on hot paths)
     std::vector<iovec> as_iovecs() const;
 };
 
@@ -2,7 +2,9 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <cerrno>
+#include <iterator>
 #include <stdexcept>
 #include <system_error>
 #include <utility>
@@ -14,6 +16,74 @@ unsigned int EventLoop::Rule::service_count() const {
     return direction == Direction::In ? fd.read_count() : fd.write_count();
 }
 
+static uint32_t epoll_events(const Direction direction) {
+    return direction == Direction::In ? EPOLLIN : EPOLLOUT;
+}
+
+//! \param[in] backend is how to wait for events; Backend::Epoll falls back to Backend::Poll if the
+//!                    kernel can't create an epoll instance
+EventLoop::EventLoop(const Backend backend) : _backend(backend) {
+    if (_backend == Backend::Epoll) {
+        const int epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0) {
+            _backend = Backend::Poll;
+        } else {
+            _epoll.emplace(epoll_fd);
+        }
+    }
+}
+
+bool EventLoop::register_rule(const list<Rule>::iterator rule) {
+    const int fd_num = rule->fd.fd_num();
+    auto reg = _registrations.find(fd_num);
+    if (reg != _registrations.end() and reg->second.rules.front()->fd.closed()) {
+        // the fd number was closed (which removed it from the epoll instance) and has been reused:
+        // the rules watching the old fd are done
+        for (const auto old_rule : vector<list<Rule>::iterator>(reg->second.rules)) {
+            cancel_rule(old_rule);
+        }
+        reg = _registrations.end();
+    }
+
+    if (reg == _registrations.end()) {
+        // registered with no events: wait_with_epoll sets them from the rules' interest
+        epoll_event event{};
+        event.data.fd = fd_num;
+        if (SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_ADD, fd_num, &event), EPERM) < 0) {
+            return false;  // e.g. a regular file, which epoll can't watch (but poll can)
+        }
+        reg = _registrations.emplace(fd_num, Registration{}).first;
+    }
+    reg->second.rules.push_back(rule);
+    return true;
+}
+
+list<EventLoop::Rule>::iterator EventLoop::cancel_rule(const list<Rule>::iterator rule) {
+    rule->cancel();
+    if (_backend == Backend::Epoll) {
+        const auto reg = _registrations.find(rule->fd.fd_num());
+        if (reg != _registrations.end()) {
+            auto &rules = reg->second.rules;
+            rules.erase(remove(rules.begin(), rules.end(), rule), rules.end());
+            if (rules.empty()) {
+                // closing the fd already removed it from the epoll instance
+                if (not rule->fd.closed()) {
+                    SystemCall(
+                        "epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_DEL, rule->fd.fd_num(), nullptr), ENOENT);
+                }
+                _registrations.erase(reg);
+            }
+        }
+    }
+    return _rules.erase(rule);
+}
+
+void EventLoop::fall_back_to_poll() {
+    _backend = Backend::Poll;
+    _registrations.clear();
+    _epoll.reset();  // closing the epoll instance drops its registrations
+}
+
 //! \param[in] fd is the FileDescriptor to be polled
 //! \param[in] direction indicates whether to poll for reading (Direction::In) or writing (Direction::Out)
 //! \param[in] callback is called when `fd` is ready.
@@ -25,10 +95,14 @@ void EventLoop::add_rule(const FileDescriptor &fd,
                          const CallbackT &callback,
                          const InterestT &interest,
                          const CallbackT &cancel) {
-    _rules.push_back({fd.duplicate(), direction, callback, interest, cancel});
+    _rules.push_back({fd.duplicate(), direction, callback, interest, cancel, false});
+    if (_backend == Backend::Epoll and not register_rule(prev(_rules.end()))) {
+        fall_back_to_poll();
+    }
 }
 
-//! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll); `wait_next_event`
+//! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll) (or
+//!                       [epoll_wait(2)](\ref man2::epoll_wait)); `wait_next_event`
 //!                       returns Result::Timeout if no fd is ready after the timeout expires.
 //! \returns Eventloop::Result indicating success, timeout, or no more Rule objects to poll.
 //!
@@ -59,6 +133,10 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! will result in a busy loop (poll returns on a ready file descriptor; file descriptor is not read or
 //! written, so it is still ready; the next call to poll will immediately return).
 EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+    return _backend == Backend::Epoll ? wait_with_epoll(timeout_ms) : wait_with_poll(timeout_ms);
+}
+
+EventLoop::Result EventLoop::wait_with_poll(const int timeout_ms) {
     vector<pollfd> pollfds{};
     pollfds.reserve(_rules.size());
     bool something_to_poll = false;
@@ -143,3 +221,94 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     return Result::Success;
 }
+
+//! \details The same steps as with poll, but the kernel keeps the fds: each wait re-evaluates the
+//! rules' interest, makes an epoll_ctl call only for an fd whose wanted events changed, and then
+//! visits only the fds epoll_wait reports ready.
+EventLoop::Result EventLoop::wait_with_epoll(const int timeout_ms) {
+    for (auto &[fd_num, reg] : _registrations) {
+        reg.wanted = 0;
+    }
+
+    bool something_to_poll = false;
+    for (auto it = _rules.begin(); it != _rules.end();) {  // NOTE: it gets erased or incremented in loop body
+        if ((it->direction == Direction::In and it->fd.eof()) or it->fd.closed()) {
+            it = cancel_rule(it);
+            continue;
+        }
+
+        it->interested = it->interest();
+        if (it->interested) {
+            _registrations.at(it->fd.fd_num()).wanted |= epoll_events(it->direction);
+            something_to_poll = true;
+        }
+        ++it;
+    }
+
+    // quit if there is nothing left to poll
+    if (not something_to_poll) {
+        return Result::Exit;
+    }
+
+    for (auto &[fd_num, reg] : _registrations) {
+        if (reg.wanted != reg.events) {
+            epoll_event event{};
+            event.events = reg.wanted;
+            event.data.fd = fd_num;
+            SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_MOD, fd_num, &event));
+            reg.events = reg.wanted;
+        }
+    }
+
+    _ready.resize(_registrations.size());
+    int ready_count = 0;
+    try {
+        ready_count = SystemCall(
+            "epoll_wait",
+            ::epoll_wait(_epoll->fd_num(), _ready.data(), static_cast<int>(_ready.size()), timeout_ms));
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+    if (ready_count == 0) {
+        return Result::Timeout;
+    }
+
+    for (int i = 0; i < ready_count; i++) {
+        const epoll_event &event = _ready[i];
+        if (event.events & EPOLLERR) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+
+        const auto reg = _registrations.find(event.data.fd);
+        if (reg == _registrations.end()) {
+            continue;
+        }
+        // a copy: a hangup cancels rules, and callbacks may add them
+        const auto rules = reg->second.rules;
+        for (const auto rule : rules) {
+            const uint32_t asked = rule->interested ? epoll_events(rule->direction) : 0;
+            const bool ready = event.events & asked;
+            if ((event.events & EPOLLHUP) and asked and not ready) {
+                // as with poll: a hangup was the only news, so this fd is defunct in this direction
+                cancel_rule(rule);
+                continue;
+            }
+
+            if (ready) {
+                const auto count_before = rule->service_count();
+                rule->callback();
+
+                // only check for busy wait if we're not canceling or exiting
+                if (count_before == rule->service_count() and rule->interest()) {
+                    throw runtime_error(
+                        "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+                }
+            }
+        }
+    }
+
+    return Result::Success;
+}
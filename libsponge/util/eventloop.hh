@@ -3,10 +3,15 @@
 
 #include "file_descriptor.hh"
 
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <list>
+#include <optional>
 #include <poll.h>
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <vector>
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop {
@@ -17,10 +22,25 @@ class EventLoop {
         Out = POLLOUT  //!< Callback will be triggered when Rule::fd is writable.
     };
 
+    //! How the EventLoop waits for its file descriptors.
+    enum class Backend {
+        Poll,  //!< Build a pollfd for every rule and call [poll(2)](\ref man2::poll) on each wait
+        Epoll  //!< Keep the fds registered with [epoll(7)](\ref man7::epoll), changing them only as interest changes
+    };
+
   private:
     using CallbackT = std::function<void(void)>;  //!< Callback for ready Rule::fd
     using InterestT = std::function<bool(void)>;  //!< `true` return indicates Rule::fd should be polled.
 
+  public:
+    //! Returned by each call to EventLoop::wait_next_event.
+    enum class Result {
+        Success,  //!< At least one Rule was triggered.
+        Timeout,  //!< No rules were triggered before timeout.
+        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
+    };
+
+  private:
     //! \brief Specifies a condition and callback that an EventLoop should handle.
     //! \details Created by calling EventLoop::add_rule() or EventLoop::add_cancelable_rule().
     class Rule {
@@ -30,6 +50,7 @@ class EventLoop {
         CallbackT callback;   //!< A callback that reads or writes fd.
         InterestT interest;   //!< A callback that returns `true` whenever fd should be polled.
         CallbackT cancel;     //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        bool interested;      //!< Rule::interest's answer on the current wait (Epoll backend)
 
         //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
         //! \details This function is used internally by EventLoop; you will not need to call it
@@ -38,13 +59,35 @@ class EventLoop {
 
     std::list<Rule> _rules{};  //!< All rules that have been added and not canceled.
 
-  public:
-    //! Returned by each call to EventLoop::wait_next_event.
-    enum class Result {
-        Success,  //!< At least one Rule was triggered.
-        Timeout,  //!< No rules were triggered before timeout.
-        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
+    Backend _backend;  //!< How wait_next_event waits (Epoll falls back to Poll if epoll is unavailable)
+
+    //! \brief An fd registered with the epoll instance, and the rules watching it (at most one epoll
+    //! registration per fd, however many rules there are)
+    struct Registration {
+        uint32_t events{0};                              //!< the events the kernel is watching for
+        uint32_t wanted{0};                              //!< the events the rules want on this wait
+        std::vector<std::list<Rule>::iterator> rules{};  //!< the rules watching this fd
     };
+    std::optional<FileDescriptor> _epoll{};                  //!< the epoll instance, with the Epoll backend
+    std::unordered_map<int, Registration> _registrations{};  //!< registrations, by fd number
+    std::vector<epoll_event> _ready{};                       //!< buffer for epoll_wait's results
+
+    //! Register a newly added rule with the epoll instance (false if epoll can't watch its fd)
+    bool register_rule(const std::list<Rule>::iterator rule);
+    //! Cancel a rule and remove it (and, if no other rule watches its fd, the fd's registration)
+    std::list<Rule>::iterator cancel_rule(const std::list<Rule>::iterator rule);
+    //! Switch to the Poll backend, dropping every epoll registration
+    void fall_back_to_poll();
+
+    Result wait_with_poll(const int timeout_ms);
+    Result wait_with_epoll(const int timeout_ms);
+
+  public:
+    //! Use `backend` to wait for events (epoll, unless asked for poll or the kernel lacks epoll)
+    explicit EventLoop(const Backend backend = Backend::Epoll);
+
+    //! The backend in use, after any fallback
+    Backend backend() const { return _backend; }
 
     //! Add a rule whose callback will be called when `fd` is ready in the specified Direction.
     void add_rule(const FileDescriptor &fd,
@@ -53,7 +96,8 @@ class EventLoop {
                   const InterestT &interest = [] { return true; },
                   const CallbackT &cancel = [] {});
 
-    //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+    //! Calls [poll(2)](\ref man2::poll) (or [epoll_wait(2)](\ref man2::epoll_wait)) and then executes callback
+    //! for each ready fd.
     Result wait_next_event(const int timeout_ms);
 };
 
@@ -72,5 +116,12 @@ using Direction = EventLoop::Direction;
 //! A Rule installed using EventLoop::add_cancelable_rule will be polled and canceled under the
 //! same conditions, with the additional condition that if Rule::callback returns `true`, the
 //! Rule will be canceled.
+//!
+//! With the Epoll backend (the default), each fd is registered with the kernel once, when its first
+//! Rule is added, and an [epoll_ctl(2)](\ref man2::epoll_ctl) call is only made when the rules' interest
+//! in it changes; each wait then costs a system call proportional to the number of ready fds, not
+//! the number of rules. The registrations are level-triggered, as poll is: a callback need only read
+//! or write once per wakeup. If epoll is unavailable, or can't watch one of the fds (e.g. a regular
+//! file), the EventLoop falls back to the Poll backend.
 
 #endif  // SPONGE_LIBSPONGE_EVENTLOOP_HH
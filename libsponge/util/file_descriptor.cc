@@ -1,5 +1,6 @@
 #include "file_descriptor.hh"
 
+#include "io_uring.hh"
 #include "util.hh"
 
 #include <algorithm>
@@ -63,6 +64,25 @@ void FileDescriptor::read(std::string &str, const size_t limit) {
     register_read();
 }
 
+//! \returns a Buffer backed by a pooled Slab, so steady-state reads don't allocate
+Buffer FileDescriptor::read_buffer() {
+    Slab slab = Slab::allocate();
+    slab.resize(Slab::CAPACITY);
+
+    const ssize_t bytes_read = SystemCall("read", ::read(fd_num(), slab.data(), Slab::CAPACITY));
+    if (bytes_read == 0) {
+        _internal_fd->_eof = true;
+    }
+    if (bytes_read > static_cast<ssize_t>(Slab::CAPACITY)) {
+        throw runtime_error("read() read more than requested");
+    }
+    slab.resize(bytes_read);
+
+    register_read();
+
+    return Buffer{move(slab)};
+}
+
 //! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
 //! \returns a vector of bytes read
 string FileDescriptor::read(const size_t limit) {
@@ -74,12 +94,18 @@ string FileDescriptor::read(const size_t limit) {
 }
 
 size_t FileDescriptor::write(BufferViewList buffer, const bool write_all) {
+    if (IOUring *ring = write_ring(); ring != nullptr) {
+        if (write_all and ring->post(*this, buffer)) {
+            return buffer.size();
+        }
+        ring->flush();  // the fd's earlier writes go first
+    }
+
     size_t total_bytes_written = 0;
 
     do {
-        auto iovecs = buffer.as_iovecs();
-
-        const ssize_t bytes_written = SystemCall("writev", ::writev(fd_num(), iovecs.data(), iovecs.size()));
+        const ssize_t bytes_written =
+            SystemCall("writev", ::writev(fd_num(), buffer.iovecs(), static_cast<int>(buffer.iovec_count())));
         if (bytes_written == 0 and buffer.size() != 0) {
             throw runtime_error("write returned 0 given non-empty input buffer");
         }
@@ -8,17 +8,20 @@
 #include <limits>
 #include <memory>
 
+class IOUring;
+
 //! A reference-counted handle to a file descriptor
 class FileDescriptor {
     //! \brief A handle on a kernel file descriptor.
     //! \details FileDescriptor objects contain a std::shared_ptr to a FDWrapper.
     class FDWrapper {
       public:
-        int _fd;                    //!< The file descriptor number returned by the kernel
-        bool _eof = false;          //!< Flag indicating whether FDWrapper::_fd is at EOF
-        bool _closed = false;       //!< Flag indicating whether FDWrapper::_fd has been closed
-        unsigned _read_count = 0;   //!< The number of times FDWrapper::_fd has been read
-        unsigned _write_count = 0;  //!< The numberof times FDWrapper::_fd has been written
+        int _fd;                         //!< The file descriptor number returned by the kernel
+        bool _eof = false;               //!< Flag indicating whether FDWrapper::_fd is at EOF
+        bool _closed = false;            //!< Flag indicating whether FDWrapper::_fd has been closed
+        unsigned _read_count = 0;        //!< The number of times FDWrapper::_fd has been read
+        unsigned _write_count = 0;       //!< The numberof times FDWrapper::_fd has been written
+        IOUring *_write_ring = nullptr;  //!< The ring FDWrapper::_fd's writes are queued on, if any
 
         //! Construct from a file descriptor number returned by the kernel
         explicit FDWrapper(const int fd);
@@ -44,10 +47,16 @@ class FileDescriptor {
     // private constructor used to duplicate the FileDescriptor (increase the reference count)
     explicit FileDescriptor(std::shared_ptr<FDWrapper> other_shared_ptr);
 
+    //! An IOUring request counts as a read or write of its fd
+    friend class IOUring;
+
   protected:
     void register_read() { ++_internal_fd->_read_count; }    //!< increment read count
     void register_write() { ++_internal_fd->_write_count; }  //!< increment write count
 
+    //! The ring set by set_write_ring(), if any
+    IOUring *write_ring() const { return _internal_fd->_write_ring; }
+
   public:
     //! Construct from a file descriptor number returned by the kernel
     explicit FileDescriptor(const int fd);
@@ -61,6 +70,9 @@ class FileDescriptor {
     //! Read up to `limit` bytes into `str` (caller can allocate storage)
     void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
 
+    //! Read up to Slab::CAPACITY bytes (e.g. one datagram from a tun/tap device) into a pooled Buffer
+    Buffer read_buffer();
+
     //! Write a string, possibly blocking until all is written
     size_t write(const char *str, const bool write_all = true) {
         return write(BufferViewList(str), write_all);
@@ -77,6 +89,11 @@ class FileDescriptor {
     //! Close the underlying file descriptor
     void close() { _internal_fd->close(); }
 
+    //! \brief Post later writes that must write everything to `ring` (see IOUring::post()), where they
+    //! wait for its next flush(), instead of making a system call each (`nullptr` to stop)
+    //! \note Only for fds whose writes are all-or-nothing, like datagram sockets and tun/tap devices
+    void set_write_ring(IOUring *ring) { _internal_fd->_write_ring = ring; }
+
     //! Copy a FileDescriptor explicitly, increasing the FDWrapper refcount
     FileDescriptor duplicate() const;
 
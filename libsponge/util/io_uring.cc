@@ -0,0 +1,312 @@
+#include "io_uring.hh"
+
+#include "util.hh"
+
+#include <numeric>
+#include <stdexcept>
+
+#ifdef SPONGE_IO_URING
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef SPONGE_IO_URING
+
+//! \details The ring is set up to complete requests cooperatively: by default a completion
+//! interrupts the process (as a signal would) to run the kernel's follow-up work, which makes a
+//! blocking epoll_wait(2) or poll(2) fail with EINTR, and EventLoop take that for a real signal.
+//! Cooperatively, the work waits for the next io_uring_enter(2) instead.
+static int io_uring_setup(const unsigned entries, io_uring_params &params) {
+    params.flags |= IORING_SETUP_COOP_TASKRUN;
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+static int io_uring_enter(const int fd, const unsigned to_submit, const unsigned min_complete, const unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+static int io_uring_register(const int fd, const unsigned opcode, const void *arg, const unsigned nr_args) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+//! \details The kernel and the process share the queues' memory: the process produces submissions
+//! (writing the SQ tail) and consumes completions (writing the CQ head), and the kernel the reverse,
+//! so each side publishes its index with a release store and reads the other's with an acquire load.
+struct IOUring::Ring {
+    //! What a posted write in buffer `index` needs kept alive until it completes
+    struct Posted {
+        size_t length{0};            //!< the bytes to write
+        msghdr header{};             //!< for a sendmsg: names `address`, and points at `iov`
+        iovec iov{};                 //!< the buffer
+        sockaddr_storage address{};  //!< the destination
+    };
+
+    FileDescriptor fd;
+    unsigned entries;
+    size_t rings_length;   //!< length of the mapping holding both queues' indices and the CQEs
+    void *rings;           //!< that mapping
+    size_t sqes_length;    //!< length of the mapping holding the SQEs
+    io_uring_sqe *sqes;    //!< that mapping
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    io_uring_cqe *cqes;
+    unsigned queued{0};            //!< requests queued since the last submit()
+    unsigned in_flight{0};         //!< requests queued and not yet reaped
+    std::vector<Posted> posted{};  //!< by buffer index
+
+    Ring(const int ring_fd, const io_uring_params &params);
+    ~Ring() {
+        ::munmap(sqes, sqes_length);
+        ::munmap(rings, rings_length);
+    }
+    Ring(const Ring &other) = delete;
+    Ring &operator=(const Ring &other) = delete;
+
+    template <typename T>
+    T *at(const uint32_t offset) const {
+        return reinterpret_cast<T *>(static_cast<char *>(rings) + offset);
+    }
+};
+
+IOUring::Ring::Ring(const int ring_fd, const io_uring_params &params)
+    : fd(ring_fd)
+    , entries(params.sq_entries)
+    // one mapping serves both queues (IORING_FEAT_SINGLE_MMAP, checked by available())
+    , rings_length(max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                       params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe)))
+    , rings(::mmap(nullptr, rings_length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING))
+    , sqes_length(params.sq_entries * sizeof(io_uring_sqe))
+    , sqes(static_cast<io_uring_sqe *>(
+          ::mmap(nullptr, sqes_length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES)))
+    , sq_head(at<unsigned>(params.sq_off.head))
+    , sq_tail(at<unsigned>(params.sq_off.tail))
+    , sq_mask(at<unsigned>(params.sq_off.ring_mask))
+    , sq_array(at<unsigned>(params.sq_off.array))
+    , cq_head(at<unsigned>(params.cq_off.head))
+    , cq_tail(at<unsigned>(params.cq_off.tail))
+    , cq_mask(at<unsigned>(params.cq_off.ring_mask))
+    , cqes(at<io_uring_cqe>(params.cq_off.cqes)) {
+    if (rings == MAP_FAILED or sqes == MAP_FAILED) {
+        throw unix_error("mmap");
+    }
+}
+
+//! \details The probe runs on a thread of its own: closing a ring interrupts every thread that has
+//! used it, and the caller's next epoll_wait(2) would fail with EINTR.
+bool IOUring::available() {
+    static const bool supported = [] {
+        bool result = false;
+        thread([&] {
+            io_uring_params params{};
+            const int fd = io_uring_setup(1, params);
+            if (fd < 0) {
+                // e.g. ENOSYS, EPERM from a seccomp filter or io_uring_disabled, or EINVAL from a kernel
+                // without IORING_SETUP_COOP_TASKRUN (before 5.19)
+                return;
+            }
+            ::close(fd);
+            result = (params.features & IORING_FEAT_SINGLE_MMAP) and (params.features & IORING_FEAT_RW_CUR_POS);
+        }).join();
+        return result;
+    }();
+    return supported;
+}
+
+IOUring::IOUring(const unsigned entries, const size_t buffer_count, const size_t buffer_size)
+    : _buffer_size(buffer_size)
+    , _memory(make_unique<char[]>(buffer_count * buffer_size))
+    , _free_buffers(buffer_count)
+    , _ring() {
+    if (not available()) {
+        throw runtime_error("IOUring: the kernel doesn't support io_uring");
+    }
+    io_uring_params params{};
+    _ring = make_unique<Ring>(SystemCall("io_uring_setup", io_uring_setup(entries, params)), params);
+
+    vector<iovec> iovecs(buffer_count);
+    for (size_t i = 0; i < buffer_count; i++) {
+        iovecs[i] = {buffer(i), buffer_size};
+    }
+    SystemCall("io_uring_register",
+               io_uring_register(
+                   _ring->fd.fd_num(), IORING_REGISTER_BUFFERS, iovecs.data(), static_cast<unsigned>(buffer_count)));
+    _ring->posted.resize(buffer_count);
+    // hand out low indices first
+    iota(_free_buffers.rbegin(), _free_buffers.rend(), 0);
+}
+
+bool IOUring::queue(
+    const uint8_t opcode, FileDescriptor &fd, const size_t index, const size_t len, const uint64_t tag) {
+    Ring &ring = *_ring;
+    const unsigned tail = *ring.sq_tail;
+    if (tail - __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE) >= ring.entries) {
+        return false;
+    }
+    const unsigned slot = tail & *ring.sq_mask;
+    io_uring_sqe &sqe = ring.sqes[slot];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.fd = fd.fd_num();
+    if (opcode == IORING_OP_SENDMSG) {
+        sqe.addr = reinterpret_cast<uint64_t>(&ring.posted[index].header);
+        sqe.len = 1;
+    } else {
+        sqe.addr = reinterpret_cast<uint64_t>(buffer(index));
+        sqe.len = static_cast<uint32_t>(len);
+        sqe.off = static_cast<uint64_t>(-1);  // the fd's current position (and ignored by sockets)
+        sqe.buf_index = static_cast<uint16_t>(index);
+    }
+    sqe.user_data = tag;
+    ring.sq_array[slot] = slot;
+    __atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring.queued++;
+    ring.in_flight++;
+
+    if (opcode == IORING_OP_READ_FIXED) {
+        fd.register_read();
+    } else {
+        fd.register_write();
+    }
+    return true;
+}
+
+bool IOUring::read(FileDescriptor &fd, const size_t index, const size_t len, const uint64_t tag) {
+    return queue(IORING_OP_READ_FIXED, fd, index, len, tag);
+}
+
+bool IOUring::write(FileDescriptor &fd, const size_t index, const size_t len, const uint64_t tag) {
+    return queue(IORING_OP_WRITE_FIXED, fd, index, len, tag);
+}
+
+bool IOUring::post(FileDescriptor &fd, const BufferViewList &payload, const Address *destination) {
+    if (payload.size() > _buffer_size) {
+        return false;
+    }
+    // keep the completions in flight within the queue (and so within the completion queue)
+    if (_free_buffers.empty() or _ring->in_flight >= _ring->entries) {
+        flush();
+    }
+
+    const size_t index = acquire_buffer().value();
+    Ring::Posted &posted = _ring->posted[index];
+    posted.length = payload.size();
+    char *out = buffer(index);
+    for (size_t i = 0; i < payload.iovec_count(); i++) {
+        const iovec &piece = payload.iovecs()[i];
+        memcpy(out, piece.iov_base, piece.iov_len);
+        out += piece.iov_len;
+    }
+
+    if (destination != nullptr) {
+        memcpy(&posted.address, static_cast<const sockaddr *>(*destination), destination->size());
+        posted.iov = {buffer(index), posted.length};
+        posted.header = {};
+        posted.header.msg_name = &posted.address;
+        posted.header.msg_namelen = destination->size();
+        posted.header.msg_iov = &posted.iov;
+        posted.header.msg_iovlen = 1;
+    }
+    queue(destination != nullptr ? IORING_OP_SENDMSG : IORING_OP_WRITE_FIXED, fd, index, posted.length, POSTED | index);
+    return true;
+}
+
+void IOUring::submit(const unsigned wait_for) {
+    const int submitted = SystemCall(
+        "io_uring_enter",
+        io_uring_enter(_ring->fd.fd_num(), _ring->queued, wait_for, wait_for > 0 ? IORING_ENTER_GETEVENTS : 0));
+    _ring->queued -= static_cast<unsigned>(submitted);
+}
+
+void IOUring::flush() {
+    if (_ring->in_flight > 0) {
+        submit(_ring->in_flight);
+    }
+    reap();
+}
+
+void IOUring::reap() {
+    Ring &ring = *_ring;
+    unsigned head = *ring.cq_head;
+    const unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+    int error = 0;
+    bool short_write = false;
+    for (; head != tail; head++) {
+        const io_uring_cqe &cqe = ring.cqes[head & *ring.cq_mask];
+        ring.in_flight--;
+        if (not(cqe.user_data & POSTED)) {
+            _completed.push_back({cqe.user_data, cqe.res});
+            continue;
+        }
+        // the buffer is free either way; report the first failure once everything is reaped
+        const size_t index = cqe.user_data & ~POSTED;
+        release_buffer(index);
+        if (cqe.res < 0) {
+            error = error != 0 ? error : -cqe.res;
+        } else if (static_cast<size_t>(cqe.res) != ring.posted[index].length) {
+            short_write = true;
+        }
+    }
+    __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+
+    if (error != 0) {
+        throw unix_error("io_uring write", error);
+    }
+    if (short_write) {
+        throw runtime_error("IOUring: a posted write came up short");
+    }
+}
+
+void IOUring::completions(vector<Completion> &out) {
+    reap();
+    out.insert(out.end(), _completed.begin(), _completed.end());
+    _completed.clear();
+}
+
+#else
+
+//! Without io_uring compiled in there is no ring
+struct IOUring::Ring {};
+
+bool IOUring::available() { return false; }
+
+IOUring::IOUring(const unsigned, const size_t, const size_t)
+    : _buffer_size(0), _memory(), _free_buffers(), _ring() {
+    throw runtime_error("IOUring: io_uring support is not compiled in (configure with -DSPONGE_IO_URING=ON)");
+}
+
+bool IOUring::queue(const uint8_t, FileDescriptor &, const size_t, const size_t, const uint64_t) { return false; }
+
+bool IOUring::read(FileDescriptor &, const size_t, const size_t, const uint64_t) { return false; }
+
+bool IOUring::write(FileDescriptor &, const size_t, const size_t, const uint64_t) { return false; }
+
+bool IOUring::post(FileDescriptor &, const BufferViewList &, const Address *) { return false; }
+
+void IOUring::submit(const unsigned) {}
+
+void IOUring::flush() {}
+
+void IOUring::reap() {}
+
+void IOUring::completions(vector<Completion> &) {}
+
+#endif
+
+IOUring::~IOUring() = default;
+
+optional<size_t> IOUring::acquire_buffer() {
+    if (_free_buffers.empty()) {
+        return {};
+    }
+    const size_t index = _free_buffers.back();
+    _free_buffers.pop_back();
+    return index;
+}
@@ -0,0 +1,120 @@
+#ifndef SPONGE_LIBSPONGE_IO_URING_HH
+#define SPONGE_LIBSPONGE_IO_URING_HH
+
+#include "address.hh"
+#include "buffer.hh"
+#include "file_descriptor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+//! \brief An [io_uring(7)](\ref man7::io_uring) instance with a pool of registered buffers, for
+//! issuing many reads and writes (on any mix of fds) in one system call
+//! \details Requests are queued with read() and write(), handed to the kernel together by submit(),
+//! and their results collected, tagged, by completions(). Every request uses one of the ring's
+//! registered buffers, which the kernel has pinned once, up front, instead of mapping the memory
+//! on each request.
+//!
+//! A FileDescriptor can also hand its writes to a ring (see FileDescriptor::set_write_ring()): each
+//! is post()ed, i.e. copied into a free buffer, which the ring takes back itself when the write
+//! completes, and they all reach the kernel at the next flush(). TCPSpongeSocket does this to send
+//! a loop turn's datagrams, and its write to the owner, in one system call.
+//!
+//! io_uring support is only compiled in with the `SPONGE_IO_URING` CMake option, and needs Linux
+//! 5.19 or later at run time; callers should check available() and otherwise fall back to
+//! FileDescriptor::read() and FileDescriptor::write() (which constructing an IOUring without
+//! support turns into a std::runtime_error).
+//!
+//! Closing a ring interrupts every thread that has used it (a blocking epoll_wait(2) fails with
+//! EINTR), so a ring is best kept to one thread, and destroyed as that thread finishes.
+//!
+//! A queued request counts as one of its fd's reads or writes (as EventLoop's busy-wait check
+//! expects), but a read that completes with 0 bytes doesn't set the fd's eof().
+class IOUring {
+  public:
+    //! A finished request
+    struct Completion {
+        uint64_t tag;  //!< the tag the request was queued with
+        int result;    //!< bytes read or written, or a negated errno
+    };
+
+    //! Is io_uring compiled in, and does the running kernel support everything IOUring uses?
+    static bool available();
+
+    //! \param[in] entries is the most requests that can be queued before a submit()
+    //! \param[in] buffer_count is the number of registered buffers in the pool
+    //! \param[in] buffer_size is the size of each registered buffer
+    IOUring(const unsigned entries, const size_t buffer_count, const size_t buffer_size);
+    ~IOUring();
+
+    //! \name The pool of registered buffers
+    //!@{
+
+    //! Take a free buffer from the pool (empty if all are in use)
+    std::optional<size_t> acquire_buffer();
+    //! Return a buffer to the pool
+    void release_buffer(const size_t index) { _free_buffers.push_back(index); }
+    //! The memory of buffer `index`
+    char *buffer(const size_t index) { return _memory.get() + index * _buffer_size; }
+    //! Size of each buffer
+    size_t buffer_size() const { return _buffer_size; }
+    //!@}
+
+    //! \brief Queue a read of up to `len` bytes from `fd` into buffer `index`
+    //! \note `tag` must leave the top bit clear (it marks posted writes)
+    //! \returns false if the queue is full (submit() first)
+    bool read(FileDescriptor &fd, const size_t index, const size_t len, const uint64_t tag);
+
+    //! \brief Queue a write of the first `len` bytes of buffer `index` to `fd`
+    //! \note `tag` must leave the top bit clear (it marks posted writes)
+    //! \returns false if the queue is full (submit() first)
+    bool write(FileDescriptor &fd, const size_t index, const size_t len, const uint64_t tag);
+
+    //! \brief Queue a write of `payload` to `fd` (or, given a `destination`, a
+    //! [sendmsg(2)](\ref man2::sendmsg) to it) from a free buffer, which the ring releases itself
+    //! \details Meant for fds whose writes are all-or-nothing, like datagram sockets and tun/tap
+    //! devices. If every buffer or queue entry is taken, flush()es first.
+    //! \returns false if `payload` doesn't fit in a buffer
+    bool post(FileDescriptor &fd, const BufferViewList &payload, const Address *destination = nullptr);
+
+    //! Hand every queued request to the kernel in one system call, then wait until at least
+    //! `wait_for` requests (queued now or before) have completed
+    void submit(const unsigned wait_for = 0);
+
+    //! \brief Hand every queued request to the kernel, and wait for all of them to complete
+    //! \details Does nothing if no request is outstanding. Throws if a posted write failed or came up short.
+    void flush();
+
+    //! Append the requests that have completed since the last call to `out` (posted writes aren't reported)
+    void completions(std::vector<Completion> &out);
+
+    //! \name
+    //! An IOUring owns kernel mappings, so it can be neither copied nor moved
+    //!@{
+    IOUring(const IOUring &other) = delete;
+    IOUring &operator=(const IOUring &other) = delete;
+    //!@}
+
+  private:
+    struct Ring;  //!< the kernel's submission and completion queues (defined only with io_uring compiled in)
+
+    //! The top bit of a tag marks a posted write (the rest is its buffer's index)
+    static constexpr uint64_t POSTED = uint64_t{1} << 63;
+
+    size_t _buffer_size;
+    std::unique_ptr<char[]> _memory;
+    std::vector<size_t> _free_buffers;
+    std::unique_ptr<Ring> _ring;
+    std::vector<Completion> _completed{};  //!< completions reaped, and not yet reported by completions()
+
+    bool queue(const uint8_t opcode, FileDescriptor &fd, const size_t index, const size_t len, const uint64_t tag);
+
+    //! Take the completions off the ring: release posted writes' buffers (throwing if one failed),
+    //! and keep the rest in _completed
+    void reap();
+};
+
+#endif  // SPONGE_LIBSPONGE_IO_URING_HH
@@ -1,5 +1,8 @@
 #include "parser.hh"
 
+#include <cstring>
+#include <stdexcept>
+
 using namespace std;
 
 //! \param[in] r is the ParseResult to show
@@ -50,8 +53,8 @@ void NetParser::remove_prefix(const size_t n) {
     _buffer.remove_prefix(n);
 }
 
-template <typename T>
-void NetUnparser::_unparse_int(string &s, T val) {
+template <typename T, typename S>
+void NetUnparser::_unparse_int(S &s, T val) {
     constexpr size_t len = sizeof(T);
     for (size_t i = 0; i < len; ++i) {
         const uint8_t the_byte = (val >> ((len - i - 1) * 8)) & 0xff;
@@ -65,8 +68,41 @@ uint16_t NetParser::u16() { return _parse_int<uint16_t>(); }
 
 uint8_t NetParser::u8() { return _parse_int<uint8_t>(); }
 
-void NetUnparser::u32(string &s, const uint32_t val) { return _unparse_int<uint32_t>(s, val); }
+template <typename S>
+void NetUnparser::u32(S &s, const uint32_t val) {
+    return _unparse_int<uint32_t>(s, val);
+}
+
+template <typename S>
+void NetUnparser::u16(S &s, const uint16_t val) {
+    return _unparse_int<uint16_t>(s, val);
+}
+
+template <typename S>
+void NetUnparser::u8(S &s, const uint8_t val) {
+    return _unparse_int<uint8_t>(s, val);
+}
 
-void NetUnparser::u16(string &s, const uint16_t val) { return _unparse_int<uint16_t>(s, val); }
+template void NetUnparser::u32<string>(string &s, const uint32_t val);
+template void NetUnparser::u16<string>(string &s, const uint16_t val);
+template void NetUnparser::u8<string>(string &s, const uint8_t val);
+template void NetUnparser::u32<HeadroomWriter>(HeadroomWriter &s, const uint32_t val);
+template void NetUnparser::u16<HeadroomWriter>(HeadroomWriter &s, const uint16_t val);
+template void NetUnparser::u8<HeadroomWriter>(HeadroomWriter &s, const uint8_t val);
 
-void NetUnparser::u8(string &s, const uint8_t val) { return _unparse_int<uint8_t>(s, val); }
+void HeadroomWriter::push_back(const char c) {
+    if (_size >= _capacity) {
+        throw length_error("HeadroomWriter::push_back");
+    }
+    _out[_size++] = c;
+}
+
+void HeadroomWriter::resize(const size_t n) {
+    if (n > _capacity) {
+        throw length_error("HeadroomWriter::resize");
+    }
+    if (n > _size) {
+        memset(_out + _size, 0, n - _size);
+    }
+    _size = n;
+}
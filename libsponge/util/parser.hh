@@ -62,18 +62,37 @@ class NetParser {
     void remove_prefix(const size_t n);
 };
 
+//! \brief A fixed-size window of bytes for NetUnparser to fill in, e.g. headroom claimed in front of a payload
+class HeadroomWriter {
+    char *_out;
+    size_t _capacity;
+    size_t _size{};
+
+  public:
+    HeadroomWriter(char *out, const size_t capacity) : _out(out), _capacity(capacity) {}
+
+    void push_back(const char c);
+    //! \brief Grow (zero-filling) or shrink the written bytes; throws if `n` exceeds the window
+    void resize(const size_t n);
+    size_t size() const { return _size; }
+};
+
+//! \note The output `S` is a std::string or a HeadroomWriter
 struct NetUnparser {
-    template <typename T>
-    static void _unparse_int(std::string &s, T val);
+    template <typename T, typename S>
+    static void _unparse_int(S &s, T val);
 
     //! Write a 32-bit integer into the data stream in network byte order
-    static void u32(std::string &s, const uint32_t val);
+    template <typename S>
+    static void u32(S &s, const uint32_t val);
 
     //! Write a 16-bit integer into the data stream in network byte order
-    static void u16(std::string &s, const uint16_t val);
+    template <typename S>
+    static void u16(S &s, const uint16_t val);
 
     //! Write an 8-bit integer into the data stream in network byte order
-    static void u8(std::string &s, const uint8_t val);
+    template <typename S>
+    static void u8(S &s, const uint8_t val);
 };
 
 #endif  // SPONGE_LIBSPONGE_PARSER_HH
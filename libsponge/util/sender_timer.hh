@@ -1,6 +1,12 @@
 #ifndef SPONGE_LIBSPONGE_TIMER_HH
 #define SPONGE_LIBSPONGE_TIMER_HH
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
 /*
 当发送一个新的segment的时候，如果timer没有开启，那么需要开启timer。
 当在RTO内收到一个合法的ACK,有两种情况:
@@ -10,6 +16,12 @@
     1.window_size = 0 : 重启timer,重传segments。
     2.window_size != 0 : double RTO, 重启timer,重传segments。
  */
+
+//! \brief The retransmission timer, and (optionally) the RTT estimator that sets its timeout
+//! \details With adaptive RTO on, the timeout follows [RFC 6298](https://tools.ietf.org/html/rfc6298):
+//! RTO = SRTT + max(G, 4 * RTTVAR), clamped to [min_rto, max_rto], where G is the 1 ms granularity
+//! of tick(). Until the first RTT sample arrives, and always with adaptive RTO off, init_rto()
+//! returns to the initial timeout.
 class TCPTimer {
 private:
     // 0 refers to the timer not start
@@ -17,17 +29,64 @@ private:
     size_t _rto;
     unsigned int _initial_timeout;
     bool _running;
+
+    bool _adaptive;
+    size_t _min_rto;
+    size_t _max_rto;
+    std::optional<double> _srtt{};  // smoothed round-trip time, in ms
+    double _rttvar{0};              // round-trip time variation, in ms
+
+    static constexpr double ALPHA = 1.0 / 8;
+    static constexpr double BETA = 1.0 / 4;
+    static constexpr double GRANULARITY = 1;
+
+    size_t estimated_rto() const {
+        const double rto = std::ceil(_srtt.value() + std::max(GRANULARITY, 4 * _rttvar));
+        return std::clamp(static_cast<size_t>(rto), _min_rto, _max_rto);
+    }
+
 public:
 
-    TCPTimer(unsigned int timeout)
-    : _time_pasted(0), _rto(timeout), _initial_timeout(timeout), _running(false){}
+    TCPTimer(unsigned int timeout, bool adaptive = false, size_t min_rto = 0, size_t max_rto = SIZE_MAX)
+    : _time_pasted(0), _rto(timeout), _initial_timeout(timeout), _running(false)
+    , _adaptive(adaptive), _min_rto(min_rto), _max_rto(std::max(min_rto, max_rto)) {}
 
     inline void init_rto() {
-        _rto = _initial_timeout;
+        _rto = _adaptive && _srtt.has_value() ? estimated_rto() : _initial_timeout;
     }
 
     inline void double_rto() {
         _rto <<= 1;
+        if (_adaptive) {
+            _rto = std::min(_rto, _max_rto);
+        }
+    }
+
+    //! \brief A segment was acknowledged `rtt` ms after it was sent. Per Karn's rule, the caller must
+    //! not take samples from retransmitted segments: their ACK may belong to either transmission.
+    void rtt_sample(const size_t rtt) {
+        const double r = static_cast<double>(rtt);
+        if (not _srtt.has_value()) {
+            _srtt = r;
+            _rttvar = r / 2;
+        } else {
+            _rttvar = (1 - BETA) * _rttvar + BETA * std::abs(_srtt.value() - r);
+            _srtt = (1 - ALPHA) * _srtt.value() + ALPHA * r;
+        }
+    }
+
+    //! \brief The smoothed round-trip time in ms, once there has been a sample
+    std::optional<double> srtt() const { return _srtt; }
+
+    //! \brief The current retransmission timeout in ms (including any backoff)
+    size_t rto() const { return _rto; }
+
+    //! \brief Milliseconds until the timer expires, if it's running
+    std::optional<size_t> remaining() const {
+        if (!_running) {
+            return {};
+        }
+        return _time_pasted < _rto ? _rto - _time_pasted : 0;
     }
 
     inline bool running() {
@@ -57,4 +116,4 @@ public:
     }
 };
 
-#endif
\ No newline at end of file
+#endif
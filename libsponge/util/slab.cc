@@ -0,0 +1,136 @@
+#include "slab.hh"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+//! Upper bound on blocks parked per thread (2 MiB); anything beyond goes back to the heap
+constexpr size_t MAX_CACHED = 1024;
+
+struct Freelist {
+    vector<void *> blocks{};
+    size_t heap_allocations{};
+
+    Freelist();
+    ~Freelist();
+    Freelist(const Freelist &) = delete;
+    Freelist &operator=(const Freelist &) = delete;
+};
+
+//! Set once this thread's Freelist is destroyed, so late releases (e.g. from other
+//! thread_local or static destructors) go straight back to the heap
+thread_local bool freelist_gone = false;
+
+Freelist::Freelist() { blocks.reserve(MAX_CACHED); }
+
+Freelist::~Freelist() {
+    for (void *block : blocks) {
+        ::operator delete(block);
+    }
+    freelist_gone = true;
+}
+
+Freelist &freelist() {
+    thread_local Freelist list;
+    return list;
+}
+
+}  // namespace
+
+Slab Slab::allocate(const size_t headroom) {
+    if (headroom > CAPACITY) {
+        throw length_error("Slab::allocate");
+    }
+
+    void *block = nullptr;
+    Freelist &list = freelist();
+    if (list.blocks.empty()) {
+        block = ::operator new(BLOCK_SIZE);
+        list.heap_allocations++;
+    } else {
+        block = list.blocks.back();
+        list.blocks.pop_back();
+    }
+    const auto head = static_cast<uint32_t>(headroom);
+    return Slab(new (block) Header{{1}, head, head});
+}
+
+void Slab::release() {
+    if (not _header) {
+        return;
+    }
+    if (_header->refcount.fetch_sub(1, memory_order_acq_rel) == 1) {
+        _header->~Header();
+        if (not freelist_gone and freelist().blocks.size() < MAX_CACHED) {
+            freelist().blocks.push_back(_header);
+        } else {
+            ::operator delete(_header);
+        }
+    }
+    _header = nullptr;
+}
+
+size_t Slab::heap_allocations() { return freelist().heap_allocations; }
+
+size_t Slab::cached() { return freelist().blocks.size(); }
+
+Slab::Slab(const Slab &other) : _header(other._header) {
+    if (_header) {
+        _header->refcount.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+Slab &Slab::operator=(const Slab &other) {
+    if (this != &other) {
+        Slab copy{other};
+        *this = move(copy);
+    }
+    return *this;
+}
+
+Slab &Slab::operator=(Slab &&other) noexcept {
+    if (this != &other) {
+        release();
+        _header = other._header;
+        other._header = nullptr;
+    }
+    return *this;
+}
+
+char *Slab::claim_headroom(const size_t at, const size_t n) {
+    if (not _header or _header->head != at or at < n) {
+        return nullptr;
+    }
+    _header->head -= n;
+    return bytes() + _header->head;
+}
+
+void Slab::push_back(const char c) {
+    if (_header->length >= CAPACITY) {
+        throw length_error("Slab::push_back");
+    }
+    bytes()[_header->length++] = c;
+}
+
+void Slab::append(string_view str) {
+    if (_header->length + str.size() > CAPACITY) {
+        throw length_error("Slab::append");
+    }
+    memcpy(bytes() + _header->length, str.data(), str.size());
+    _header->length += str.size();
+}
+
+void Slab::resize(const size_t n) {
+    if (_header->head + n > CAPACITY) {
+        throw length_error("Slab::resize");
+    }
+    if (n > size()) {
+        memset(bytes() + _header->length, 0, n - size());
+    }
+    _header->length = _header->head + n;
+}
@@ -0,0 +1,86 @@
+#ifndef SPONGE_LIBSPONGE_SLAB_HH
+#define SPONGE_LIBSPONGE_SLAB_HH
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+//! \brief A reference-counted, fixed-size byte block recycled through a per-thread freelist
+//! \details Slabs are sized to hold one Ethernet frame, so a serialized header or a datagram read
+//! from a tun/tap device fits in one. Releasing the last reference returns the block to the
+//! freelist of the releasing thread instead of the heap, so steady-state traffic allocates nothing.
+//! The reference count lives in the block's header, next to the bytes it guards.
+//!
+//! A slab may be allocated with headroom: its contents then start partway into the block, and
+//! lower layers can later claim the bytes in front (see Buffer::claim_headroom()) to write their
+//! headers in place, like a Linux `sk_buff`.
+class Slab {
+  public:
+    //! Size of each block, header included
+    static constexpr size_t BLOCK_SIZE = 2048;
+
+  private:
+    struct Header {
+        std::atomic<uint32_t> refcount;
+        uint32_t head;    //!< offset of the first claimed byte; only ever moves backwards
+        uint32_t length;  //!< offset one past the last written byte
+    };
+
+    Header *_header{};
+
+    explicit Slab(Header *header) : _header(header) {}
+
+    char *bytes() const { return reinterpret_cast<char *>(_header + 1); }
+    void release();
+
+    //! Claim the `n` bytes in front of offset `at`, if `at` is the first claimed byte and there is room
+    char *claim_headroom(const size_t at, const size_t n);
+
+    friend class Buffer;
+
+  public:
+    //! Usable bytes in each slab, headroom included
+    static constexpr size_t CAPACITY = BLOCK_SIZE - sizeof(Header);
+
+    //! Headroom for a TCP payload: an Ethernet header plus maximum-length IPv4 and TCP headers
+    static constexpr size_t PACKET_HEADROOM = 14 + 60 + 60;
+
+    //! \brief Take an empty slab from this thread's freelist (or the heap if the freelist is empty)
+    //! \param[in] headroom is the number of bytes to leave free in front of the contents
+    static Slab allocate(const size_t headroom = 0);
+
+    //! \name Pool statistics for the calling thread
+    //!@{
+    static size_t heap_allocations();  //!< blocks ever obtained from the heap
+    static size_t cached();            //!< blocks currently sitting in the freelist
+    //!@}
+
+    //! \brief An empty handle that owns nothing
+    Slab() = default;
+    ~Slab() { release(); }
+
+    //! \name Copying shares the block; moving transfers the reference
+    //!@{
+    Slab(const Slab &other);
+    Slab(Slab &&other) noexcept : _header(other._header) { other._header = nullptr; }
+    Slab &operator=(const Slab &other);
+    Slab &operator=(Slab &&other) noexcept;
+    //!@}
+
+    explicit operator bool() const { return _header; }
+
+    //! \name Writing (only meaningful while the slab is not shared)
+    //!@{
+    char *data() { return bytes() + _header->head; }
+    void push_back(const char c);
+    void append(std::string_view str);
+    //! \brief Grow (zero-filling) or shrink the contents; throws if they would not fit
+    void resize(const size_t n);
+    //!@}
+
+    std::string_view str() const { return _header ? std::string_view{bytes() + _header->head, size()} : std::string_view{}; }
+    size_t size() const { return _header ? _header->length - _header->head : 0; }
+};
+
+#endif  // SPONGE_LIBSPONGE_SLAB_HH
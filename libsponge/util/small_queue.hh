@@ -0,0 +1,153 @@
+#ifndef SPONGE_LIBSPONGE_SMALL_QUEUE_HH
+#define SPONGE_LIBSPONGE_SMALL_QUEUE_HH
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//! \brief A FIFO of `T` that keeps up to `N` elements inline and only touches the heap beyond that
+//! \details Elements are always contiguous, so the live range can be handed to the kernel
+//! (e.g. as an `iovec` array) without copying. Popping from the front just advances an index;
+//! the storage is rewound once the queue drains, so a push/pop steady state never allocates.
+template <typename T, size_t N>
+class SmallQueue {
+    static_assert(N > 0, "SmallQueue needs at least one inline slot");
+
+  private:
+    std::array<T, N> _inline{};
+    std::vector<T> _heap{};  //!< only used once more than `N` elements have been live at once
+    bool _spilled{};
+    size_t _begin{};  //!< index of the front element in the active storage
+    size_t _end{};    //!< one past the back element in the active storage
+
+    T *storage() { return _spilled ? _heap.data() : _inline.data(); }
+    const T *storage() const { return _spilled ? _heap.data() : _inline.data(); }
+
+    //! Move the live elements from the inline array to the heap
+    void spill() {
+        _heap.clear();
+        _heap.reserve(2 * N);
+        for (size_t i = _begin; i < _end; i++) {
+            _heap.push_back(std::move(_inline[i]));
+            _inline[i] = T{};
+        }
+        _end -= _begin;
+        _begin = 0;
+        _spilled = true;
+    }
+
+    //! After a move: drop the moved-from elements and return to the empty inline state
+    void reset_moved_from() {
+        _inline.fill(T{});
+        _heap.clear();
+        _spilled = false;
+        _begin = _end = 0;
+    }
+
+  public:
+    SmallQueue() = default;
+    SmallQueue(const SmallQueue &other) = default;
+    SmallQueue &operator=(const SmallQueue &other) = default;
+    ~SmallQueue() = default;
+
+    //! \brief Moving leaves `other` empty (its indices would otherwise describe elements it no longer has)
+    SmallQueue(SmallQueue &&other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : _inline(std::move(other._inline))
+        , _heap(std::move(other._heap))
+        , _spilled(other._spilled)
+        , _begin(other._begin)
+        , _end(other._end) {
+        other.reset_moved_from();
+    }
+
+    //! \brief Moving leaves `other` empty
+    SmallQueue &operator=(SmallQueue &&other) noexcept(std::is_nothrow_move_assignable_v<T>) {
+        if (this != &other) {
+            _inline = std::move(other._inline);
+            _heap = std::move(other._heap);
+            _spilled = other._spilled;
+            _begin = other._begin;
+            _end = other._end;
+            other.reset_moved_from();
+        }
+        return *this;
+    }
+
+    //! \name Element access
+    //!@{
+    T *begin() { return storage() + _begin; }
+    T *end() { return storage() + _end; }
+    const T *begin() const { return storage() + _begin; }
+    const T *end() const { return storage() + _end; }
+    const T *data() const { return begin(); }
+
+    T &front() { return *begin(); }
+    const T &front() const { return *begin(); }
+    T &operator[](const size_t i) { return begin()[i]; }
+    const T &operator[](const size_t i) const { return begin()[i]; }
+    //!@}
+
+    size_t size() const { return _end - _begin; }
+    bool empty() const { return _begin == _end; }
+
+    void push_back(T value) {
+        if (not _spilled) {
+            if (_end == N and _begin > 0) {
+                // slide the live elements down to reuse the slots freed by pop_front()
+                for (size_t i = _begin; i < _end; i++) {
+                    _inline[i - _begin] = std::move(_inline[i]);
+                    _inline[i] = T{};
+                }
+                _end -= _begin;
+                _begin = 0;
+            }
+            if (_end < N) {
+                _inline[_end++] = std::move(value);
+                return;
+            }
+            spill();
+        }
+        if (_begin > N and 2 * _begin > _end) {
+            // most of the heap is popped slots; drop them so a queue that never drains stays bounded
+            _heap.erase(_heap.begin(), _heap.begin() + _begin);
+            _end -= _begin;
+            _begin = 0;
+        }
+        _heap.push_back(std::move(value));
+        _end++;
+    }
+
+    void push_front(T value) {
+        if (_begin == 0) {
+            // no free slot in front: rebuild with the new element first
+            SmallQueue rebuilt;
+            rebuilt.push_back(std::move(value));
+            for (T &element : *this) {
+                rebuilt.push_back(std::move(element));
+            }
+            *this = std::move(rebuilt);
+            return;
+        }
+        storage()[--_begin] = std::move(value);
+    }
+
+    void pop_front() {
+        storage()[_begin++] = T{};  // release whatever the element holds (e.g. a Buffer's reference)
+        if (_begin == _end) {
+            clear();
+        }
+    }
+
+    void clear() {
+        for (size_t i = _begin; i < _end; i++) {
+            storage()[i] = T{};
+        }
+        _heap.clear();  // keeps its capacity
+        _spilled = false;
+        _begin = _end = 0;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_SMALL_QUEUE_HH
@@ -1,5 +1,6 @@
 #include "socket.hh"
 
+#include "io_uring.hh"
 #include "util.hh"
 
 #include <cstddef>
@@ -116,13 +117,11 @@ void sendmsg_helper(const int fd_num,
                     const sockaddr *destination_address,
                     const socklen_t destination_address_len,
                     const BufferViewList &payload) {
-    auto iovecs = payload.as_iovecs();
-
     msghdr message{};
     message.msg_name = const_cast<sockaddr *>(destination_address);
     message.msg_namelen = destination_address_len;
-    message.msg_iov = iovecs.data();
-    message.msg_iovlen = iovecs.size();
+    message.msg_iov = const_cast<iovec *>(payload.iovecs());
+    message.msg_iovlen = payload.iovec_count();
 
     const ssize_t bytes_sent = SystemCall("sendmsg", ::sendmsg(fd_num, &message, 0));
 
@@ -132,11 +131,23 @@ void sendmsg_helper(const int fd_num,
 }
 
 void UDPSocket::sendto(const Address &destination, const BufferViewList &payload) {
+    if (IOUring *ring = write_ring(); ring != nullptr) {
+        if (ring->post(*this, payload, &destination)) {
+            return;
+        }
+        ring->flush();  // the socket's earlier datagrams go first
+    }
     sendmsg_helper(fd_num(), destination, destination.size(), payload);
     register_write();
 }
 
 void UDPSocket::send(const BufferViewList &payload) {
+    if (IOUring *ring = write_ring(); ring != nullptr) {
+        if (ring->post(*this, payload)) {
+            return;
+        }
+        ring->flush();  // the socket's earlier datagrams go first
+    }
     sendmsg_helper(fd_num(), nullptr, 0, payload);
     register_write();
 }
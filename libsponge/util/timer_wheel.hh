@@ -0,0 +1,181 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+//! \brief A hierarchical timing wheel of millisecond deadlines, each carrying a `T`
+//! \details Timers live in LEVELS wheels of SLOTS slots. A timer sits in the lowest level whose slot
+//! width separates its deadline from the current time: level 0 holds the deadlines in the current
+//! 64 ms block (one slot per ms), level 1 those in the current 4096 ms block (one slot per 64 ms), and
+//! so on up to level 3 (spanning about 4.7 hours); later deadlines wait in an overflow list. When time
+//! enters a slot of a higher level, its timers cascade down to where they now belong. So scheduling
+//! and cancelling are O(1), each timer is moved at most LEVELS times, and advance() jumps straight
+//! across empty stretches of time rather than visiting each millisecond.
+//!
+//! Expired timers aren't called back; advance() hands each one's value to the caller, so a timer
+//! needn't hold a pointer to its owner (which may move).
+template <typename T>
+class TimerWheel {
+  public:
+    using TimerId = uint64_t;  //!< Names a scheduled timer, for cancel()
+
+    static constexpr unsigned int SLOT_BITS = 6;     //!< each level has 2^SLOT_BITS slots
+    static constexpr size_t SLOTS = 1 << SLOT_BITS;  //!< slots per level
+    static constexpr unsigned int LEVELS = 4;        //!< number of levels
+
+  private:
+    struct Timer {
+        uint64_t deadline;  //!< when it expires, in ms
+        TimerId id;         //!< its name
+        T value;            //!< what advance() hands back when it expires
+    };
+    using Slot = std::list<Timer>;
+
+    //! Where a timer is: its slot (level LEVELS being the overflow list) and its place in it
+    struct Location {
+        unsigned int level;
+        size_t slot;
+        typename Slot::iterator timer;
+    };
+
+    std::array<std::array<Slot, SLOTS>, LEVELS> _wheel{};  //!< the slots, by level
+    std::array<uint64_t, LEVELS> _occupied{};              //!< for each level, a bit for each non-empty slot
+    Slot _overflow{};                                      //!< timers beyond the top level's span
+    std::unordered_map<TimerId, Location> _index{};        //!< every timer, by id
+    uint64_t _now;                                         //!< the current time, in ms
+    TimerId _next_id{0};                                   //!< the id for the next timer scheduled
+
+    static constexpr unsigned int TOP_BITS = SLOT_BITS * LEVELS;  //!< the span of the whole wheel is 2^TOP_BITS ms
+
+    //! The slot timer `it` (in `from`) belongs in at the current time; moves it there
+    void place(Slot &from, const typename Slot::iterator it) {
+        const uint64_t differ = it->deadline ^ _now;
+        unsigned int level = 0;
+        while (level < LEVELS and (differ >> (SLOT_BITS * (level + 1))) != 0) {
+            level++;
+        }
+
+        Slot *to = &_overflow;
+        size_t slot = 0;
+        if (level < LEVELS) {
+            slot = (it->deadline >> (SLOT_BITS * level)) & (SLOTS - 1);
+            to = &_wheel[level][slot];
+            _occupied[level] |= uint64_t{1} << slot;
+        }
+        to->splice(to->end(), from, it);
+        _index.insert_or_assign(it->id, Location{level, slot, it});
+    }
+
+    //! Move every timer in `slot` to where it belongs at the current time
+    void cascade(Slot &slot) {
+        // (overflow timers may belong in the overflow list again)
+        Slot moving;
+        moving.splice(moving.end(), slot);
+        while (not moving.empty()) {
+            place(moving, moving.begin());
+        }
+    }
+
+  public:
+    //! A wheel whose time starts at `now_ms`
+    explicit TimerWheel(const uint64_t now_ms = 0) : _now(now_ms) {}
+
+    //! The time, in ms, as of the last advance()
+    uint64_t now() const { return _now; }
+
+    //! The number of timers scheduled
+    size_t size() const { return _index.size(); }
+
+    //! Schedule `value` to expire at `deadline_ms` (or, if that isn't in the future, 1 ms from now)
+    TimerId schedule(const uint64_t deadline_ms, T value) {
+        Slot pending;
+        pending.push_back({deadline_ms > _now ? deadline_ms : _now + 1, _next_id, std::move(value)});
+        place(pending, pending.begin());
+        return _next_id++;
+    }
+
+    //! Cancel a timer that hasn't expired yet
+    //! \returns `true` if there was such a timer
+    bool cancel(const TimerId id) {
+        const auto entry = _index.find(id);
+        if (entry == _index.end()) {
+            return false;
+        }
+        const Location &where = entry->second;
+        if (where.level == LEVELS) {
+            _overflow.erase(where.timer);
+        } else {
+            Slot &slot = _wheel[where.level][where.slot];
+            slot.erase(where.timer);
+            if (slot.empty()) {
+                _occupied[where.level] &= ~(uint64_t{1} << where.slot);
+            }
+        }
+        _index.erase(entry);
+        return true;
+    }
+
+    //! \brief The next time advance() has work to do, if any timers are scheduled
+    //! \details This is the earliest deadline when it lies within the current 64 ms block; otherwise it
+    //! is the time the earliest timer cascades, which may come before its deadline. Either way, a
+    //! caller can sleep until then.
+    std::optional<uint64_t> next_expiry() const {
+        for (unsigned int level = 0; level < LEVELS; level++) {
+            const unsigned int shift = SLOT_BITS * level;
+            const uint64_t current = (_now >> shift) & (SLOTS - 1);
+            const uint64_t later = current == SLOTS - 1 ? 0 : _occupied[level] & (~uint64_t{0} << (current + 1));
+            if (later != 0) {
+                const uint64_t block = (_now >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+                return block | (static_cast<uint64_t>(__builtin_ctzll(later)) << shift);
+            }
+        }
+        if (not _overflow.empty()) {
+            return ((_now >> TOP_BITS) + 1) << TOP_BITS;
+        }
+        return {};
+    }
+
+    //! \brief Move time forward to `now_ms`, calling `expire(T &&value)` for each timer that expires
+    //! \details Timers expire in order of their deadlines. `expire` may schedule and cancel timers.
+    template <typename ExpireT>
+    void advance(const uint64_t now_ms, ExpireT &&expire) {
+        for (auto next = next_expiry(); next.has_value() and next.value() <= now_ms; next = next_expiry()) {
+            _now = next.value();
+
+            // timers in the slots time has just entered, from the top level down, move to lower levels
+            if ((_now & ((uint64_t{1} << TOP_BITS) - 1)) == 0) {
+                cascade(_overflow);
+            }
+            for (unsigned int level = LEVELS - 1; level > 0; level--) {
+                const unsigned int shift = SLOT_BITS * level;
+                if ((_now & ((uint64_t{1} << shift) - 1)) == 0) {
+                    const size_t slot = (_now >> shift) & (SLOTS - 1);
+                    _occupied[level] &= ~(uint64_t{1} << slot);
+                    cascade(_wheel[level][slot]);
+                }
+            }
+
+            // what's left in the current level-0 slot expires now
+            const size_t current = _now & (SLOTS - 1);
+            Slot &due = _wheel[0][current];
+            while (not due.empty()) {
+                T value = std::move(due.front().value);
+                _index.erase(due.front().id);
+                due.pop_front();
+                expire(std::move(value));
+            }
+            _occupied[0] &= ~(uint64_t{1} << current);
+        }
+        if (now_ms > _now) {
+            _now = now_ms;
+        }
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
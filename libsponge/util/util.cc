@@ -3,11 +3,17 @@
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <sys/socket.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 //! \returns the number of milliseconds since the program started
@@ -69,6 +75,160 @@ mt19937 get_random_generator() {
     return mt19937(seed);
 }
 
+//! \details Two compression rounds per word and four finalization rounds, over the 8 * words.size() bytes the
+//! words make up (so the final block is just the length).
+uint64_t siphash(const array<uint64_t, 2> &key, const initializer_list<uint64_t> words) {
+    uint64_t v0 = key[0] ^ 0x736f6d6570736575ULL;
+    uint64_t v1 = key[1] ^ 0x646f72616e646f6dULL;
+    uint64_t v2 = key[0] ^ 0x6c7967656e657261ULL;
+    uint64_t v3 = key[1] ^ 0x7465646279746573ULL;
+    const auto rotl = [](const uint64_t x, const int b) { return (x << b) | (x >> (64 - b)); };
+    const auto round = [&] {
+        v0 += v1;
+        v1 = rotl(v1, 13) ^ v0;
+        v0 = rotl(v0, 32);
+        v2 += v3;
+        v3 = rotl(v3, 16) ^ v2;
+        v0 += v3;
+        v3 = rotl(v3, 21) ^ v0;
+        v2 += v1;
+        v1 = rotl(v1, 17) ^ v2;
+        v2 = rotl(v2, 32);
+    };
+    const auto compress = [&](const uint64_t m) {
+        v3 ^= m;
+        round();
+        round();
+        v0 ^= m;
+    };
+
+    for (const uint64_t m : words) {
+        compress(m);
+    }
+    compress(uint64_t{words.size() * 8 % 256} << 56);
+    v2 ^= 0xff;
+    for (unsigned int i = 0; i < 4; i++) {
+        round();
+    }
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+namespace {
+
+//! Fold a ones'-complement sum down to 16 bits; the result is 0 only if `sum` is
+uint32_t fold(uint64_t sum) {
+    while (sum > 0xffff) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return static_cast<uint32_t>(sum);
+}
+
+// Each kernel sums an even number of bytes as native-endian 16-bit words and returns the
+// unfolded ones'-complement sum. Summing wider words is equivalent, since 2^16 == 1 (mod 0xffff).
+
+uint64_t sum_word(const char *data, size_t len) {
+    uint64_t sum = 0;
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        sum += (word & 0xffffffff) + (word >> 32);
+    }
+    for (; len >= 2; data += 2, len -= 2) {
+        uint16_t word;
+        memcpy(&word, data, sizeof(word));
+        sum += word;
+    }
+    return sum;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+//! Vector iterations between flushes of the 32-bit lane sums (each iteration adds < 2^17 per lane)
+constexpr size_t SIMD_FLUSH_INTERVAL = 1 << 14;
+
+__attribute__((target("sse2"))) uint64_t sum_sse2(const char *data, size_t len) {
+    const __m128i low_halves = _mm_set1_epi32(0xffff);
+    uint64_t sum = 0;
+    while (len >= 16) {
+        __m128i sums = _mm_setzero_si128();  // four 32-bit lanes, each summing 16-bit words
+        for (size_t n = 0; n < SIMD_FLUSH_INTERVAL and len >= 16; n++, data += 16, len -= 16) {
+            const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+            sums = _mm_add_epi32(sums, _mm_and_si128(words, low_halves));
+            sums = _mm_add_epi32(sums, _mm_srli_epi32(words, 16));
+        }
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), sums);
+        sum += uint64_t{lanes[0]} + lanes[1] + lanes[2] + lanes[3];
+    }
+    return sum + sum_word(data, len);
+}
+
+__attribute__((target("avx2"))) uint64_t sum_avx2(const char *data, size_t len) {
+    const __m256i low_halves = _mm256_set1_epi32(0xffff);
+    uint64_t sum = 0;
+    while (len >= 32) {
+        __m256i sums = _mm256_setzero_si256();  // eight 32-bit lanes, each summing 16-bit words
+        for (size_t n = 0; n < SIMD_FLUSH_INTERVAL and len >= 32; n++, data += 32, len -= 32) {
+            const __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+            sums = _mm256_add_epi32(sums, _mm256_and_si256(words, low_halves));
+            sums = _mm256_add_epi32(sums, _mm256_srli_epi32(words, 16));
+        }
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sums);
+        for (const uint32_t lane : lanes) {
+            sum += lane;
+        }
+    }
+    return sum + sum_word(data, len);
+}
+#endif
+
+//! Inputs shorter than this always use the Word kernel
+constexpr size_t SHORT_INPUT = 64;
+
+InternetChecksum::Kernel best_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+    // this runs during static initialization, possibly before libgcc has initialized the CPU model
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return InternetChecksum::Kernel::AVX2;
+    }
+#endif
+    // SSE2 only runs level with Word (see apps/checksum_benchmark), so it isn't picked by default
+    return InternetChecksum::Kernel::Word;
+}
+
+InternetChecksum::Kernel active_kernel = best_kernel();
+
+}  // namespace
+
+bool InternetChecksum::supported(const Kernel kernel) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+#endif
+    switch (kernel) {
+        case Kernel::Bytewise:
+        case Kernel::Word:
+            return true;
+#if defined(__x86_64__) || defined(__i386__)
+        case Kernel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+InternetChecksum::Kernel InternetChecksum::kernel() { return active_kernel; }
+
+void InternetChecksum::set_kernel(const Kernel kernel) {
+    if (not supported(kernel)) {
+        throw runtime_error("InternetChecksum::set_kernel: not supported on this CPU");
+    }
+    active_kernel = kernel;
+}
+
 //! \note This class returns the checksum in host byte order.
 //!       See https://commandcenter.blogspot.com/2012/04/byte-order-fallacy.html for rationale
 //! \details This class can be used to either check or compute an Internet checksum
@@ -87,24 +247,79 @@ mt19937 get_random_generator() {
 InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
 
 void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
+    if (active_kernel == Kernel::Bytewise) {
+        for (size_t i = 0; i < data.size(); i++) {
+            uint16_t val = uint8_t(data[i]);
+            if (not _parity) {
+                val <<= 8;
+            }
+            _sum += val;
+            _parity = !_parity;
         }
-        _sum += val;
-        _parity = !_parity;
+        return;
+    }
+
+    if (data.empty()) {
+        return;
+    }
+
+    // finish a 16-bit word left half-done by the previous call
+    if (_parity) {
+        _sum += uint8_t(data.front());
+        data.remove_prefix(1);
+        _parity = false;
+    }
+
+    const size_t even_len = data.size() & ~size_t{1};
+    uint64_t native_sum = 0;
+    // headers are too short for the vector setup to pay off
+    switch (even_len < SHORT_INPUT ? Kernel::Word : active_kernel) {
+#if defined(__x86_64__) || defined(__i386__)
+        case Kernel::AVX2:
+            native_sum = sum_avx2(data.data(), even_len);
+            break;
+        case Kernel::SSE2:
+            native_sum = sum_sse2(data.data(), even_len);
+            break;
+#endif
+        default:
+            native_sum = sum_word(data.data(), even_len);
+    }
+    uint32_t words = fold(native_sum);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // a byte-swapped sum is the sum of the byte-swapped words (RFC 1071)
+    words = ((words & 0xff) << 8) | (words >> 8);
+#endif
+    _sum += words;
+
+    if (data.size() & 1) {
+        _sum += uint32_t{uint8_t(data.back())} << 8;
+        _parity = true;
     }
+
+    _sum = (_sum & 0xffff) + (_sum >> 16);  // keep headroom for the next call
 }
 
-uint16_t InternetChecksum::value() const {
+uint16_t InternetChecksum::value() const { return ~sum(); }
+
+uint16_t InternetChecksum::sum() const {
     uint32_t ret = _sum;
 
     while (ret > 0xffff) {
         ret = (ret >> 16) + (ret & 0xffff);
     }
 
-    return ~ret;
+    return ret;
+}
+
+uint16_t InternetChecksum::update(const uint16_t old_cksum, const uint16_t old_field, const uint16_t new_field) {
+    const uint32_t sum = uint16_t(~old_cksum) + uint16_t(~old_field) + uint32_t{new_field};
+    return ~fold(sum);
+}
+
+uint16_t InternetChecksum::update(const uint16_t old_cksum, const uint32_t old_field, const uint32_t new_field) {
+    const uint16_t high = update(old_cksum, uint16_t(old_field >> 16), uint16_t(new_field >> 16));
+    return update(high, uint16_t(old_field & 0xffff), uint16_t(new_field & 0xffff));
 }
 
 //! \param[in] data is a pointer to the bytes to show
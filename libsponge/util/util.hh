@@ -2,9 +2,11 @@
 #define SPONGE_LIBSPONGE_UTIL_HH
 
 #include <algorithm>
+#include <array>
 #include <cerrno>
 #include <cstddef>
 #include <cstdint>
+#include <initializer_list>
 #include <iterator>
 #include <ostream>
 #include <random>
@@ -51,16 +53,50 @@ std::mt19937 get_random_generator();
 //! Get the time in milliseconds since the program began.
 uint64_t timestamp_ms();
 
+//! \brief [SipHash-2-4](https://www.aumasson.jp/siphash/siphash.pdf) of `words` (as their little-endian bytes)
+//! under the 128-bit `key`: a keyed pseudorandom function, for hashes an attacker must not be able to predict
+uint64_t siphash(const std::array<uint64_t, 2> &key, const std::initializer_list<uint64_t> words);
+
 //! The internet checksum algorithm
+//! \details add() sums the bulk of its input with the fastest kernel the CPU supports (chosen at startup);
+//! every kernel produces the same value() as the original byte-at-a-time loop.
 class InternetChecksum {
   private:
     uint32_t _sum;
     bool _parity{};
 
   public:
+    //! Implementations of the summing loop
+    enum class Kernel {
+        Bytewise,  //!< one byte per iteration (the reference)
+        Word,      //!< 64 bits per iteration, portable
+        SSE2,      //!< 128 bits per iteration
+        AVX2,      //!< 256 bits per iteration
+    };
+
+    //! \name Kernel selection (for tests and benchmarks)
+    //!@{
+    static bool supported(const Kernel kernel);
+    static Kernel kernel();
+    //! \note Not thread-safe; throws if the CPU does not support `kernel`
+    static void set_kernel(const Kernel kernel);
+    //!@}
+
     InternetChecksum(const uint32_t initial_sum = 0);
     void add(std::string_view data);
     uint16_t value() const;
+
+    //! \brief The folded ones'-complement sum so far (value() before the final complement)
+    //! \details A partial sum can be cached and fed back in later through the constructor's `initial_sum`.
+    uint16_t sum() const;
+
+    //! \brief Recompute a checksum after a 16-bit field it covers changed from `old_field` to `new_field`
+    //! \details [RFC 1624](https://tools.ietf.org/html/rfc1624), eqn. 3: HC' = ~(~HC + ~m + m'). The field must start at an
+    //! even offset in the checksummed data. Gives the same result as summing everything again.
+    static uint16_t update(const uint16_t old_cksum, const uint16_t old_field, const uint16_t new_field);
+
+    //! \brief As above, for a 32-bit field (e.g. a sequence or acknowledgment number)
+    static uint16_t update(const uint16_t old_cksum, const uint32_t old_field, const uint32_t new_field);
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
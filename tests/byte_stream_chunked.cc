@@ -0,0 +1,116 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        const auto chunked = ByteStream::Storage::Chunked;
+
+        {
+            ByteStreamTestHarness test{"chunked-write-pop", 15, chunked};
+
+            // small writes are copied into one growing chunk
+            test.execute(Write{"cat"});
+            test.execute(WriteBuffer{"tac"});
+            test.execute(BytesWritten{6});
+            test.execute(RemainingCapacity{9});
+            test.execute(BufferSize{6});
+            test.execute(Peek{"cattac"});
+            test.execute(PeekViews{"cattac", ""});
+            test.execute(PeekViews{"catt", ""});
+
+            test.execute(Pop{2});
+            test.execute(PeekViews{"ttac", ""});
+            test.execute(Peek{"ttac"});
+
+            test.execute(Pop{2});
+            test.execute(BytesRead{4});
+            test.execute(RemainingCapacity{13});
+            test.execute(PeekViews{"ac", ""});
+
+            test.execute(EndInput{});
+            test.execute(Pop{2});
+            test.execute(BufferEmpty{true});
+            test.execute(Eof{true});
+        }
+
+        {
+            ByteStreamTestHarness test{"chunked-capacity", 5, chunked};
+
+            test.execute(WriteBuffer{"abc"}.with_bytes_written(3));
+            test.execute(WriteBuffer{"defg"}.with_bytes_written(2));
+            test.execute(WriteBuffer{"h"}.with_bytes_written(0));
+            test.execute(RemainingCapacity{0});
+            test.execute(Peek{"abcde"});
+
+            test.execute(ReadBuffer{2, "ab"});
+            test.execute(ReadBuffer{10, "cde"});
+            test.execute(ReadBuffer{10, ""});
+            test.execute(BytesRead{5});
+            test.execute(RemainingCapacity{5});
+        }
+
+        {
+            ByteStreamTestHarness test{"chunked-large-buffers", 4000, chunked};
+            const string big(1000, 'b');
+
+            // large Buffers are queued as chunks of their own, with small writes between them
+            test.execute(WriteBuffer{big});
+            test.execute(Write{"s"});
+            test.execute(WriteBuffer{big});
+            test.execute(WriteBuffer{"t"});
+            test.execute(PeekViews{big, "s"});
+            test.execute(ReadBuffer{2000, big});
+            test.execute(ReadBuffer{2000, "s"});
+            test.execute(ReadBuffer{2000, big});
+            test.execute(ReadBuffer{2000, "t"});
+        }
+
+        // tiny payloads don't pin the slabs they arrived in
+        {
+            constexpr size_t N = 50;
+            ByteStream stream{1000, chunked};
+            const size_t cached = Slab::cached(), allocated = Slab::heap_allocations();
+            {
+                vector<Buffer> payloads;
+                for (size_t i = 0; i < N; i++) {
+                    Slab slab = Slab::allocate(Slab::PACKET_HEADROOM);
+                    slab.push_back('a' + i % 26);
+                    payloads.emplace_back(move(slab));
+                }
+                for (const auto &payload : payloads) {
+                    stream.write(payload);
+                }
+            }
+            // every slab is back in the freelist but the one the bytes were copied into
+            const size_t held = cached + (Slab::heap_allocations() - allocated) - Slab::cached();
+            if (held != 1) {
+                throw runtime_error("the stream holds " + to_string(held) + " slabs for " + to_string(N) + " bytes");
+            }
+            if (stream.buffer_size() != N or stream.peek_views(N)[0].size() != N) {
+                throw runtime_error("tiny payloads should be coalesced into one chunk");
+            }
+        }
+
+        {
+            ByteStreamTestHarness test{"ring-read-buffer", 4};
+
+            test.execute(WriteBuffer{"abc"});
+            test.execute(WriteBuffer{"def"}.with_bytes_written(1));
+            test.execute(ReadBuffer{3, "abc"});
+            test.execute(ReadBuffer{3, "d"});
+            test.execute(BufferEmpty{true});
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -45,11 +45,14 @@ void ByteStreamAction::execute(ByteStream &) const {}
 
 ByteStreamAction::~ByteStreamAction() {}
 
-ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity)
-    : _test_name(test_name), _byte_stream(capacity) {
+ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name,
+                                             const size_t capacity,
+                                             const ByteStream::Storage storage)
+    : _test_name(test_name), _byte_stream(capacity, storage) {
     std::ostringstream ss;
     ss << "Initialized with ("
-       << "capacity=" << capacity << ")";
+       << "capacity=" << capacity << ", storage=" << (storage == ByteStream::Storage::Ring ? "ring" : "chunked")
+       << ")";
     _steps_executed.emplace_back(ss.str());
 }
 
@@ -97,11 +100,43 @@ void Write::execute(ByteStream &bs) const {
     }
 }
 
+// WriteBuffer
+WriteBuffer::WriteBuffer(const std::string &data) : _data(data) {}
+WriteBuffer &WriteBuffer::with_bytes_written(const size_t bytes_written) {
+    _bytes_written = bytes_written;
+    return *this;
+}
+std::string WriteBuffer::description() const { return "write Buffer \"" + _data + "\""; }
+void WriteBuffer::execute(ByteStream &bs) const {
+    auto bytes_written = bs.write(Buffer{string(_data)});
+    if (_bytes_written and bytes_written != _bytes_written.value()) {
+        throw ByteStreamExpectationViolation::property("bytes_written", _bytes_written.value(), bytes_written);
+    }
+}
+
+// ReadBuffer
+ReadBuffer::ReadBuffer(const size_t len, const std::string &output) : _len(len), _output(output) {}
+std::string ReadBuffer::description() const {
+    return "read_buffer(" + to_string(_len) + ") returning \"" + _output + "\"";
+}
+void ReadBuffer::execute(ByteStream &bs) const {
+    const auto output = bs.read_buffer(_len);
+    if (output.str() != _output) {
+        throw ByteStreamExpectationViolation("Expected read_buffer(" + to_string(_len) + ") to return \"" +
+                                             _output + "\", but it returned \"" + output.copy() + "\"");
+    }
+}
+
 // Pop
 Pop::Pop(const size_t len) : _len(len) {}
 std::string Pop::description() const { return "pop " + to_string(_len); }
 void Pop::execute(ByteStream &bs) const { bs.pop_output(_len); }
 
+// Consume
+Consume::Consume(const size_t len) : _len(len) {}
+std::string Consume::description() const { return "consume " + to_string(_len); }
+void Consume::execute(ByteStream &bs) const { bs.consume(_len); }
+
 // InputEnded
 InputEnded::InputEnded(const bool input_ended) : _input_ended(input_ended) {}
 std::string InputEnded::description() const { return "input_ended: " + to_string(_input_ended); }
@@ -172,6 +207,20 @@ void BytesRead::execute(ByteStream &bs) const {
     }
 }
 
+// PeekViews
+PeekViews::PeekViews(const std::string &first, const std::string &second) : _first(first), _second(second) {}
+std::string PeekViews::description() const {
+    return "\"" + _first + "\" + \"" + _second + "\" viewed at the front of the stream";
+}
+void PeekViews::execute(ByteStream &bs) const {
+    const auto views = bs.peek_views(_first.size() + _second.size());
+    if (views[0] != _first or views[1] != _second) {
+        throw ByteStreamExpectationViolation("Expected \"" + _first + "\" + \"" + _second +
+                                             "\" viewed at the front of the stream, but found \"" +
+                                             string(views[0]) + "\" + \"" + string(views[1]) + "\"");
+    }
+}
+
 // Peek
 Peek::Peek(const std::string &output) : _output(output) {}
 std::string Peek::description() const { return "\"" + _output + "\" at the front of the stream"; }
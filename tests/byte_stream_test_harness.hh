@@ -56,6 +56,25 @@ struct Write : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+struct WriteBuffer : public ByteStreamAction {
+    std::string _data;
+    std::optional<size_t> _bytes_written{};
+
+    WriteBuffer(const std::string &data);
+    WriteBuffer &with_bytes_written(const size_t bytes_written);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
+struct ReadBuffer : public ByteStreamAction {
+    size_t _len;
+    std::string _output;
+
+    ReadBuffer(const size_t len, const std::string &output);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct Pop : public ByteStreamAction {
     size_t _len;
 
@@ -64,6 +83,14 @@ struct Pop : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+struct Consume : public ByteStreamAction {
+    size_t _len;
+
+    Consume(const size_t len);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct InputEnded : public ByteStreamExpectation {
     bool _input_ended;
 
@@ -128,13 +155,24 @@ struct Peek : public ByteStreamExpectation {
     void execute(ByteStream &) const override;
 };
 
+struct PeekViews : public ByteStreamExpectation {
+    std::string _first;
+    std::string _second;
+
+    PeekViews(const std::string &first, const std::string &second);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 class ByteStreamTestHarness {
     std::string _test_name;
     ByteStream _byte_stream;
     std::vector<std::string> _steps_executed{};
 
   public:
-    ByteStreamTestHarness(const std::string &test_name, const size_t capacity);
+    ByteStreamTestHarness(const std::string &test_name,
+                          const size_t capacity,
+                          const ByteStream::Storage storage = ByteStream::Storage::Ring);
 
     void execute(const ByteStreamTestStep &step);
 };
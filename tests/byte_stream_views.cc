@@ -0,0 +1,63 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"views-contiguous", 8};
+
+            test.execute(Write{"cat"});
+            test.execute(PeekViews{"cat", ""});
+            test.execute(PeekViews{"ca", ""});
+
+            test.execute(Consume{1});
+            test.execute(BytesRead{1});
+            test.execute(BufferSize{2});
+            test.execute(RemainingCapacity{6});
+            test.execute(PeekViews{"at", ""});
+            test.execute(Peek{"at"});
+        }
+
+        {
+            ByteStreamTestHarness test{"views-wrap", 8};
+
+            test.execute(Write{"abcdef"});
+            test.execute(Consume{5});
+            test.execute(Write{"ghijk"});
+            test.execute(BufferSize{6});
+            test.execute(PeekViews{"fgh", "ijk"});
+            test.execute(Peek{"fghijk"});
+
+            test.execute(Consume{4});
+            test.execute(PeekViews{"jk", ""});
+            test.execute(BytesRead{9});
+            test.execute(BytesWritten{11});
+        }
+
+        {
+            ByteStreamTestHarness test{"views-odd-capacity", 3};
+
+            test.execute(Write{"ab"});
+            test.execute(Consume{2});
+            test.execute(Write{"cdef"}.with_bytes_written(3));
+            test.execute(RemainingCapacity{0});
+            test.execute(PeekViews{"cd", "e"});
+
+            test.execute(Consume{10});
+            test.execute(BufferEmpty{true});
+            test.execute(PeekViews{"", ""});
+            test.execute(EndInput{});
+            test.execute(Eof{true});
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+#include "eventloop.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <utility>
+
+using namespace std;
+
+using Backend = EventLoop::Backend;
+using Result = EventLoop::Result;
+
+static pair<LocalStreamSocket, LocalStreamSocket> socket_pair() {
+    int fds[2];
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    return {LocalStreamSocket{FileDescriptor{fds[0]}}, LocalStreamSocket{FileDescriptor{fds[1]}}};
+}
+
+static void expect(const bool condition, const string &backend, const string &what) {
+    if (not condition) {
+        throw runtime_error(backend + ": " + what);
+    }
+}
+
+static void test_backend(const Backend backend, const string &name) {
+    // interest turning on and off
+    {
+        auto [a, b] = socket_pair();
+        EventLoop loop{backend};
+        expect(loop.backend() == backend, name, "unexpected fallback");
+        bool want = false;
+        string received;
+        loop.add_rule(a, Direction::In, [&] { received += a.read(); }, [&] { return want; });
+
+        b.write("hello");
+        expect(loop.wait_next_event(0) == Result::Exit, name, "an uninterested rule should not be polled");
+        want = true;
+        expect(loop.wait_next_event(100) == Result::Success, name, "readable fd not reported");
+        expect(received == "hello", name, "callback didn't read the data");
+        expect(loop.wait_next_event(0) == Result::Timeout, name, "nothing more to read, so expected a timeout");
+        b.write("again");
+        want = false;
+        expect(loop.wait_next_event(0) == Result::Exit, name, "interest turned off, but the fd was polled");
+        want = true;
+        expect(loop.wait_next_event(100) == Result::Success, name, "interest turned back on, but no event");
+        expect(received == "helloagain", name, "callback didn't read the second write");
+    }
+
+    // reading and writing rules on the same fd
+    {
+        auto [a, b] = socket_pair();
+        EventLoop loop{backend};
+        string received, echoed;
+        loop.add_rule(a, Direction::In, [&] { received += a.read(); });
+        loop.add_rule(
+            a,
+            Direction::Out,
+            [&] {
+                a.write(received.substr(echoed.size()));
+                echoed = received;
+            },
+            [&] { return echoed.size() < received.size(); });
+        b.write("ping");
+        expect(loop.wait_next_event(100) == Result::Success, name, "readable fd not reported");
+        expect(received == "ping" and echoed.empty(), name, "only the reading rule should have run");
+        expect(loop.wait_next_event(100) == Result::Success, name, "writable fd not reported");
+        expect(echoed == "ping" and b.read() == "ping", name, "the writing rule should have run");
+    }
+
+    // the peer closing: the reading rule sees EOF and is canceled
+    {
+        auto [a, b] = socket_pair();
+        EventLoop loop{backend};
+        bool canceled = false;
+        loop.add_rule(a, Direction::In, [&] { a.read(); }, [] { return true; }, [&] { canceled = true; });
+        b.close();
+        expect(loop.wait_next_event(100) == Result::Success, name, "EOF not reported");
+        expect(a.eof() and not canceled, name, "callback should have read the EOF");
+        expect(loop.wait_next_event(0) == Result::Exit and canceled, name, "rule at EOF should be canceled");
+    }
+
+    // an fd closed by its owner is dropped, and its number can be reused
+    {
+        auto [a, b] = socket_pair();
+        EventLoop loop{backend};
+        bool first_canceled = false;
+        loop.add_rule(a, Direction::In, [&] { a.read(); }, [] { return true; }, [&] { first_canceled = true; });
+        const int fd_num = a.fd_num();
+        a.close();
+        auto [c, d] = socket_pair();
+        string received;
+        if (c.fd_num() != fd_num) {
+            swap(c, d);
+        }
+        loop.add_rule(c, Direction::In, [&] { received += c.read(); });
+        d.write("reused");
+        expect(loop.wait_next_event(100) == Result::Success, name, "fd reusing a closed fd's number not polled");
+        expect(first_canceled and received == "reused", name, "closed fd's rule should be canceled");
+    }
+}
+
+int main() {
+    try {
+        test_backend(Backend::Poll, "poll");
+        test_backend(Backend::Epoll, "epoll");
+
+        // epoll can't watch /dev/null, so the loop falls back to poll, keeping the rules it has
+        {
+            auto [a, b] = socket_pair();
+            EventLoop loop{};
+            string received;
+            loop.add_rule(a, Direction::In, [&] { received += a.read(); });
+            FileDescriptor null{SystemCall("open", ::open("/dev/null", O_RDONLY))};
+            loop.add_rule(null, Direction::In, [&] { null.read(); });
+            expect(loop.backend() == Backend::Poll, "fallback", "epoll should have refused /dev/null");
+            b.write("still here");
+            expect(loop.wait_next_event(100) == Result::Success, "fallback", "no event after falling back");
+            expect(received == "still here", "fallback", "rule added before the fallback was lost");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
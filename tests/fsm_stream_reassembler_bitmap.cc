@@ -0,0 +1,111 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+static constexpr auto BITMAP = StreamReassembler::Engine::Bitmap;
+
+int main() {
+    try {
+        {
+            ReassemblerTestHarness test{8, BITMAP};
+
+            test.execute(SubmitSegment{"efgh", 4});
+            test.execute(UnassembledBytes(4));
+            test.execute(SubmitSegment{"fgh", 5});
+            test.execute(UnassembledBytes(4));
+            test.execute(SubmitSegment{"abcdefghij", 0});
+            test.execute(BytesAssembled(8));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcdefgh"));
+        }
+
+        {
+            // walk far enough past the 64-byte ring to wrap around it several times
+            ReassemblerTestHarness test{20, BITMAP};
+            string stream;
+            for (size_t i = 0; i < 300; i++) {
+                stream.push_back('a' + i % 26);
+            }
+
+            for (size_t base = 0; base < stream.size(); base += 15) {
+                const size_t len = min<size_t>(15, stream.size() - base);
+                const bool last = base + len == stream.size();
+                const size_t split = len / 3;
+                test.execute(SubmitSegment{stream.substr(base + split, len - split), base + split}.with_eof(last));
+                test.execute(UnassembledBytes(len - split));
+                test.execute(SubmitSegment{stream.substr(base, split + 1), base});
+                test.execute(UnassembledBytes(0));
+                test.execute(BytesAssembled(base + len));
+                test.execute(BytesAvailable(stream.substr(base, len)));
+            }
+            test.execute(AtEof{});
+        }
+
+        {
+            // held runs that cross bitmap words and the end of the 128-byte ring
+            ReassemblerTestHarness test{100, BITMAP};
+            test.execute(SubmitSegment{string(90, 'a'), 0});
+            test.execute(BytesAvailable(string(90, 'a')));
+            test.execute(SubmitSegment{string(60, 'b'), 100});
+            test.execute(SubmitSegment{string(10, 'c'), 170});
+            test.execute(HeldIntervals({{100, 160}, {170, 180}}));
+        }
+
+        {
+            // the bitmap engine must agree with the interval-map engine on random overlapping input
+            auto rd = get_random_generator();
+            for (size_t rep = 0; rep < 32; rep++) {
+                const size_t capacity = 1 + rd() % 3000;
+                const size_t len = 1 + rd() % 10000;
+                string data(len, 0);
+                generate(data.begin(), data.end(), [&] { return rd(); });
+
+                StreamReassembler map_engine{capacity};
+                StreamReassembler bitmap_engine{capacity, ByteStream::Storage::Ring, BITMAP};
+                string map_out, bitmap_out;
+
+                while (map_out.size() < len) {
+                    const size_t index = map_out.size() + rd() % (capacity + 10);
+                    if (index >= len) {
+                        continue;
+                    }
+                    const size_t size = min<size_t>(len - index, 1 + rd() % 1500);
+                    const bool eof = index + size == len;
+                    map_engine.push_substring(data.substr(index, size), index, eof);
+                    bitmap_engine.push_substring(data.substr(index, size), index, eof);
+
+                    if (map_engine.unassembled_bytes() != bitmap_engine.unassembled_bytes()) {
+                        throw runtime_error("engines disagree on unassembled_bytes()");
+                    }
+                    if (map_engine.held_intervals() != bitmap_engine.held_intervals()) {
+                        throw runtime_error("engines disagree on held_intervals()");
+                    }
+                    if (rd() % 2) {
+                        map_out += map_engine.stream_out().read(map_engine.stream_out().buffer_size());
+                        bitmap_out += bitmap_engine.stream_out().read(bitmap_engine.stream_out().buffer_size());
+                    }
+                    if (map_out != bitmap_out) {
+                        throw runtime_error("engines disagree on the reassembled stream");
+                    }
+                }
+                if (map_out != data or bitmap_out != data or not bitmap_engine.stream_out().eof()) {
+                    throw runtime_error("reassembled stream does not match the input");
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
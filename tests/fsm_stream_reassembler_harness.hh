@@ -10,6 +10,7 @@
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 class ReassemblerExpectationViolation : public std::runtime_error {
   public:
@@ -103,6 +104,29 @@ struct UnassembledBytes : public ReassemblerExpectation {
     }
 };
 
+struct HeldIntervals : public ReassemblerExpectation {
+    std::vector<std::pair<uint64_t, uint64_t>> _intervals;
+
+    HeldIntervals(std::vector<std::pair<uint64_t, uint64_t>> intervals) : _intervals(std::move(intervals)) {}
+
+    static std::string format(const std::vector<std::pair<uint64_t, uint64_t>> &intervals) {
+        std::ostringstream ss;
+        for (const auto &[begin, end] : intervals) {
+            ss << "[" << begin << ", " << end << ")";
+        }
+        return ss.str();
+    }
+
+    std::string description() const { return "held intervals = " + format(_intervals); }
+
+    void execute(StreamReassembler &reassembler) const {
+        if (reassembler.held_intervals() != _intervals) {
+            throw ReassemblerExpectationViolation("The reassembler was expected to hold `" + format(_intervals) +
+                                                  "`, but it held `" + format(reassembler.held_intervals()) + "`");
+        }
+    }
+};
+
 struct AtEof : public ReassemblerExpectation {
     AtEof() {}
     std::string description() const {
@@ -164,8 +188,11 @@ class ReassemblerTestHarness {
     std::vector<std::string> steps_executed;
 
   public:
-    ReassemblerTestHarness(const size_t capacity) : reassembler(capacity), steps_executed() {
-        steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ")");
+    ReassemblerTestHarness(const size_t capacity,
+                           const StreamReassembler::Engine engine = StreamReassembler::Engine::IntervalMap)
+        : reassembler(capacity, ByteStream::Storage::Ring, engine), steps_executed() {
+        steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ", engine = " +
+                                    (engine == StreamReassembler::Engine::Bitmap ? "bitmap" : "interval map") + ")");
     }
 
     void execute(const ReassemblerTestStep &step) {
@@ -5,6 +5,9 @@
 
 #include <exception>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 using namespace std;
 
@@ -20,6 +23,19 @@ int main() {
             test.execute(NotAtEof{});
         }
 
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"cd", 2});
+            test.execute(SubmitSegment{"gh", 6});
+            test.execute(SubmitSegment{"ef", 4});
+            test.execute(SubmitSegment{"k", 10});
+            test.execute(HeldIntervals({{2, 8}, {10, 11}}));
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(HeldIntervals({{10, 11}}));
+            test.execute(BytesAvailable("abcdefgh"));
+        }
+
         {
             ReassemblerTestHarness test{65000};
 
@@ -131,6 +147,30 @@ int main() {
             test.execute(BytesAvailable(""));
             test.execute(AtEof{});
         }
+
+        // tiny out-of-order payloads don't pin the slabs they arrived in
+        {
+            constexpr size_t N = 50;
+            StreamReassembler reassembler{1000, ByteStream::Storage::Chunked};
+            const size_t cached = Slab::cached(), allocated = Slab::heap_allocations();
+            {
+                vector<Buffer> payloads;
+                for (size_t i = 0; i < N; i++) {
+                    Slab slab = Slab::allocate(Slab::PACKET_HEADROOM);
+                    slab.push_back('a' + i % 26);
+                    payloads.emplace_back(move(slab));
+                }
+                // every other byte, leaving holes
+                for (size_t i = 0; i < N; i++) {
+                    reassembler.push_substring(payloads[i], 1 + 2 * i, false);
+                }
+            }
+            const size_t held = cached + (Slab::heap_allocations() - allocated) - Slab::cached();
+            if (reassembler.unassembled_bytes() != N or held != 1) {
+                throw runtime_error("the reassembler holds " + to_string(held) + " slabs for " + to_string(N) +
+                                    " bytes");
+            }
+        }
     } catch (const exception &e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
@@ -0,0 +1,106 @@
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+using Kernel = InternetChecksum::Kernel;
+
+//! Checksum `data` fed in pieces at `cuts`, starting from `initial_sum`, with the given kernel
+static uint16_t checksum(const Kernel kernel, const string &data, const vector<size_t> &cuts, const uint32_t initial_sum) {
+    InternetChecksum::set_kernel(kernel);
+    InternetChecksum check(initial_sum);
+    size_t start = 0;
+    for (const size_t cut : cuts) {
+        check.add(string_view(data).substr(start, cut - start));
+        start = cut;
+    }
+    check.add(string_view(data).substr(start));
+    return check.value();
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const Kernel best = InternetChecksum::kernel();
+        const vector<Kernel> kernels{Kernel::Word, Kernel::SSE2, Kernel::AVX2};
+
+        // every kernel matches the byte-at-a-time reference, for any length, alignment and split
+        for (unsigned int i = 0; i < 20000; i++) {
+            const size_t len = i < 200 ? i : uniform_int_distribution<size_t>{0, 3000}(rd);
+            const size_t offset = rd() % 32;
+            string storage(offset + len, 0);
+            const bool saturated = i % 7 == 0;  // runs of 0xff push every carry path
+            for (auto &c : storage) {
+                c = saturated ? char(0xff) : char(rd());
+            }
+            if (i % 11 == 0) {
+                storage.assign(storage.size(), 0);  // an all-zero sum must stay distinguishable from 0xffff
+            }
+            const string data = storage.substr(offset);
+
+            vector<size_t> cuts;
+            if (len > 0) {
+                for (unsigned int n = rd() % 4; n > 0; n--) {
+                    cuts.push_back(rd() % len);
+                }
+                sort(cuts.begin(), cuts.end());
+            }
+            const uint32_t initial_sum = i % 3 ? rd() % 0x40000 : 0;
+
+            const uint16_t expected = checksum(Kernel::Bytewise, data, cuts, initial_sum);
+            for (const Kernel kernel : kernels) {
+                if (InternetChecksum::supported(kernel) and checksum(kernel, data, cuts, initial_sum) != expected) {
+                    throw runtime_error("checksum kernel " + to_string(static_cast<int>(kernel)) +
+                                        " disagrees with the reference on " + to_string(len) + " bytes");
+                }
+            }
+        }
+        InternetChecksum::set_kernel(best);
+
+        // incremental updates match a full recomputation
+        for (unsigned int i = 0; i < 20000; i++) {
+            string header(20, 0);
+            for (auto &c : header) {
+                c = char(rd());
+            }
+            InternetChecksum before;
+            before.add(header);
+
+            const size_t at = 2 * (rd() % 8);
+            const uint32_t old_field = (uint32_t{uint8_t(header[at])} << 24) | (uint32_t{uint8_t(header[at + 1])} << 16) |
+                                       (uint32_t{uint8_t(header[at + 2])} << 8) | uint8_t(header[at + 3]);
+            const uint32_t new_field = i % 5 ? rd() : old_field ^ 0xffff;
+            for (size_t b = 0; b < 4; b++) {
+                header[at + b] = char(new_field >> (24 - 8 * b));
+            }
+            InternetChecksum after;
+            after.add(header);
+
+            if (InternetChecksum::update(before.value(), old_field, new_field) != after.value()) {
+                throw runtime_error("32-bit incremental checksum update disagrees with recomputation");
+            }
+            const auto old_low = uint16_t(old_field & 0xffff);
+            const auto new_low = uint16_t(new_field & 0xffff);
+            InternetChecksum high_only;
+            high_only.add(header.substr(0, at + 2));
+            high_only.add(string{char(old_low >> 8), char(old_low & 0xff)});
+            high_only.add(header.substr(at + 4));
+            if (InternetChecksum::update(high_only.value(), old_low, new_low) != after.value()) {
+                throw runtime_error("16-bit incremental checksum update disagrees with recomputation");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#include "io_uring.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        if (not IOUring::available()) {
+            try {
+                IOUring ring{4, 1, 16};
+                throw runtime_error("constructing an IOUring without io_uring support should fail");
+            } catch (const runtime_error &e) {
+                if (string(e.what()).find("IOUring") == string::npos) {
+                    throw;
+                }
+            }
+            cerr << "io_uring unavailable: only checked the fallback\n";
+            return EXIT_SUCCESS;
+        }
+
+        int fds[2];
+        SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, static_cast<int *>(fds)));
+        FileDescriptor a{fds[0]}, b{fds[1]};
+
+        IOUring ring{2, 3, 64};
+        const auto out = ring.acquire_buffer().value();
+        const auto in = ring.acquire_buffer().value();
+        const auto spare = ring.acquire_buffer().value();
+        if (ring.acquire_buffer().has_value()) {
+            throw runtime_error("the pool should have run out of buffers");
+        }
+        ring.release_buffer(spare);
+        if (ring.acquire_buffer() != spare) {
+            throw runtime_error("a released buffer should be handed out again");
+        }
+
+        string("hello").copy(ring.buffer(out), 5);
+        if (not ring.read(b, in, 64, 1) or not ring.write(a, out, 5, 2)) {
+            throw runtime_error("queueing into an empty ring failed");
+        }
+        if (ring.write(a, out, 5, 3)) {
+            throw runtime_error("a full ring should refuse more requests");
+        }
+        ring.submit(2);
+
+        vector<IOUring::Completion> done;
+        ring.completions(done);
+        if (done.size() != 2) {
+            throw runtime_error("expected 2 completions, got " + to_string(done.size()));
+        }
+        for (const auto &completion : done) {
+            if (completion.result != 5) {
+                throw runtime_error("request " + to_string(completion.tag) + " returned " +
+                                    to_string(completion.result));
+            }
+        }
+        if (string(ring.buffer(in), 5) != "hello") {
+            throw runtime_error("the read didn't land in its registered buffer");
+        }
+
+        // completions are only reported once
+        done.clear();
+        ring.completions(done);
+        if (not done.empty()) {
+            throw runtime_error("completions reported twice");
+        }
+
+        // a socket's posted datagrams wait on the ring until it's flushed, in order
+        UDPSocket rx, tx;
+        rx.bind(Address("127.0.0.1", 0));
+        const Address to = rx.local_address();
+        IOUring posts{4, 2, 64};
+        tx.set_write_ring(&posts);
+        const auto writes_before = tx.write_count();
+        tx.sendto(to, string("one"));
+        tx.sendto(to, string("two"));
+        if (tx.write_count() != writes_before + 2) {
+            throw runtime_error("posted writes should count as the socket's writes");
+        }
+        pollfd pfd{rx.fd_num(), POLLIN, 0};
+        if (SystemCall("poll", ::poll(&pfd, 1, 0)) != 0) {
+            throw runtime_error("a posted datagram was sent before the flush");
+        }
+        // with both buffers taken, this one flushes the first two
+        tx.sendto(to, string("three"));
+        // too big for a buffer: the ring is flushed, and it's sent directly
+        tx.sendto(to, string(100, 'x'));
+        for (const string &expected : vector<string>{"one", "two", "three", string(100, 'x')}) {
+            if (rx.recv().payload != expected) {
+                throw runtime_error("expected the datagram \"" + expected + "\"");
+            }
+        }
+
+        // posted writes aren't reported as completions
+        posts.flush();
+        posts.completions(done);
+        if (not done.empty()) {
+            throw runtime_error("a posted write was reported as a completion");
+        }
+        tx.set_write_ring(nullptr);
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
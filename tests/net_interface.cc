@@ -313,6 +313,35 @@ int main() {
                            make_arp(ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5").serialize())});
             test.execute(ExpectNoFrame{});
         }
+
+        {
+            const EthernetAddress local_eth = random_private_ethernet_address();
+            NetworkInterfaceTestHarness test{"idle owner wakes to expire mappings", local_eth, Address("4.3.2.1", 0)};
+
+            // nothing held, nothing to wait for
+            test.execute(Idle{60000});
+
+            const EthernetAddress target_eth = random_private_ethernet_address();
+            test.execute(ReceiveFrame{
+                make_frame(
+                    target_eth,
+                    local_eth,
+                    EthernetHeader::TYPE_ARP,
+                    make_arp(ARPMessage::OPCODE_REPLY, target_eth, "192.168.0.1", local_eth, "4.3.2.1").serialize()),
+                {}});
+            test.execute(ExpectNoFrame{});
+
+            // the owner is only woken by next_timeout(), and that must be enough to expire the mapping on time
+            test.execute(Idle{30001});
+            const auto datagram = make_datagram("5.6.7.8", "13.12.11.10");
+            test.execute(SendDatagram{datagram, Address("192.168.0.1", 0)});
+            test.execute(ExpectFrame{
+                make_frame(local_eth,
+                           ETHERNET_BROADCAST,
+                           EthernetHeader::TYPE_ARP,
+                           make_arp(ARPMessage::OPCODE_REQUEST, local_eth, "4.3.2.1", {}, "192.168.0.1").serialize())});
+            test.execute(ExpectNoFrame{});
+        }
     } catch (const exception &e) {
         cerr << e.what() << endl;
         return EXIT_FAILURE;
@@ -170,3 +170,17 @@ void ExpectNoFrame::execute(NetworkInterface &interface) const {
 string Tick::description() const { return to_string(_ms) + " ms pass"; }
 
 void Tick::execute(NetworkInterface &interface) const { interface.tick(_ms); }
+
+string Idle::description() const { return to_string(_ms) + " ms pass with the owner waiting on next_timeout()"; }
+
+void Idle::execute(NetworkInterface &interface) const {
+    size_t elapsed = 0;
+    for (auto timeout = interface.next_timeout(); timeout.has_value() and elapsed + timeout.value() <= _ms;
+         timeout = interface.next_timeout()) {
+        if (timeout.value() == 0) {
+            throw NetworkInterfaceExpectationViolation("NetworkInterface asked to be ticked with no time passed");
+        }
+        interface.tick(timeout.value());
+        elapsed += timeout.value();
+    }
+}
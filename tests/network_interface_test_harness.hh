@@ -78,6 +78,16 @@ struct Tick : public NetworkInterfaceAction {
     Tick(const size_t ms) : _ms(ms) {}
 };
 
+//! The owner's event loop with nothing else to do for `ms`: it wakes only when next_timeout() says so, and ticks
+struct Idle : public NetworkInterfaceAction {
+    size_t _ms;
+
+    std::string description() const override;
+    void execute(NetworkInterface &interface) const override;
+
+    Idle(const size_t ms) : _ms(ms) {}
+};
+
 class NetworkInterfaceTestHarness {
     std::string _test_name;
     NetworkInterface _interface;
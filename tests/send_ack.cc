@@ -65,6 +65,25 @@ int main() {
             test.execute(ExpectState{TCPSenderStateSummary::SYN_SENT});
         }
 
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(UINT32_MAX - 2);
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"ACK covering segments on both sides of the seqno wraparound", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectState{TCPSenderStateSummary::SYN_ACKED});
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("a").with_seqno(isn + 1));
+            test.execute(WriteBytes{"bc"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("bc").with_seqno(isn + 2));
+            test.execute(ExpectBytesInFlight{3});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectNoSegment{});
+        }
+
         /* remove requirement to send corrective ACK for bad ACK
             {
                 TCPConfig cfg;
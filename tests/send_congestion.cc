@@ -0,0 +1,182 @@
+#include "congestion_control.hh"
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+using Algorithm = CongestionControl::Algorithm;
+
+static void expect_segments(TCPSenderTestHarness &test, const size_t count, const size_t size) {
+    for (size_t i = 0; i < count; i++) {
+        test.execute(ExpectSegment{}.with_payload_size(size));
+    }
+    test.execute(ExpectNoSegment{});
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        for (const Algorithm algorithm : {Algorithm::NewReno, Algorithm::Cubic}) {
+            {
+                TCPConfig cfg;
+                WrappingInt32 isn(rd());
+                cfg.fixed_isn = isn;
+                cfg.congestion_control = algorithm;
+
+                TCPSenderTestHarness test{"Initial window is ten segments, then slow start doubles it", cfg};
+                test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+                test.execute(WriteBytes(string(50 * mss, 'x')));
+                expect_segments(test, 10, mss);
+                test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * mss}}.with_win(60000));
+                expect_segments(test, 20, mss);
+            }
+
+            {
+                TCPConfig cfg;
+                WrappingInt32 isn(rd());
+                cfg.fixed_isn = isn;
+                cfg.congestion_control = algorithm;
+
+                TCPSenderTestHarness test{"Three duplicate ACKs trigger a fast retransmit", cfg};
+                test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+                test.execute(WriteBytes(string(5 * mss, 'x')));
+                expect_segments(test, 5, mss);
+                test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+                test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+                test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+                test.execute(ExpectNoSegment{});
+                test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+                test.execute(ExpectNoSegment{});
+                // a partial ACK retransmits the next hole immediately
+                test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * mss}}.with_win(60000));
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 3 * mss));
+                test.execute(ExpectNoSegment{});
+                test.execute(AckReceived{WrappingInt32{isn + 1 + 5 * mss}}.with_win(60000));
+                test.execute(ExpectBytesInFlight{0});
+            }
+
+            {
+                TCPConfig cfg;
+                WrappingInt32 isn(rd());
+                const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+                cfg.fixed_isn = isn;
+                cfg.rt_timeout = rto;
+                cfg.congestion_control = algorithm;
+
+                TCPSenderTestHarness test{"A timeout restarts slow start from one segment", cfg};
+                test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+                test.execute(WriteBytes(string(3 * mss, 'x')));
+                expect_segments(test, 3, mss);
+                test.execute(Tick{rto});
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+                test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * mss}}.with_win(60000));
+                // one segment, plus the three just acknowledged
+                test.execute(WriteBytes(string(10 * mss, 'x')));
+                expect_segments(test, 4, mss);
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without congestion control, duplicate ACKs are ignored", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes(string(20 * mss, 'x')));
+            expect_segments(test, 20, mss);
+            for (unsigned int i = 0; i < 5; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        // congestion avoidance: NewReno adds a segment per window; CUBIC regrows to the window of
+        // the last loss within K seconds, plateaus there, then probes beyond it
+        {
+            NewReno reno{mss};
+            reno.on_fast_retransmit(0);
+            reno.on_recovery_exit();
+            if (reno.cwnd() != 5 * mss) {
+                throw runtime_error("NewReno should halve the window on loss");
+            }
+            for (unsigned int round = 0; round < 10; round++) {
+                const size_t window = reno.cwnd();
+                for (size_t acked = 0; acked < window; acked += mss) {
+                    reno.on_ack(mss, 0);
+                }
+                if (reno.cwnd() != window + mss) {
+                    throw runtime_error("NewReno should grow by one segment per window");
+                }
+            }
+
+            Cubic cubic{mss};
+            for (unsigned int i = 0; i < 90; i++) {
+                cubic.on_ack(mss, 0);  // slow start to 100 segments
+            }
+            cubic.on_fast_retransmit(0);
+            cubic.on_recovery_exit();
+            if (cubic.cwnd() != 70 * mss) {
+                throw runtime_error("CUBIC should reduce the window to 70% on loss");
+            }
+            // K = cbrt(100 * 0.3 / 0.4) ~= 4.2 s
+            uint64_t now = 1000;
+            for (; now < 4200; now += 10) {
+                cubic.on_ack(mss, now);
+            }
+            if (cubic.cwnd() < 95 * mss or cubic.cwnd() > 101 * mss) {
+                throw runtime_error("CUBIC should be back near its old window after K seconds, not at " +
+                                    to_string(cubic.cwnd() / mss) + " segments");
+            }
+            for (; now < 12000; now += 10) {
+                cubic.on_ack(mss, now);
+            }
+            if (cubic.cwnd() < 150 * mss) {
+                throw runtime_error("CUBIC should probe well beyond its old window once past K");
+            }
+        }
+
+        // however far the cubic curve has run ahead of the window, one round trip grows it by at most half
+        {
+            Cubic cubic{mss};
+            for (unsigned int i = 0; i < 90; i++) {
+                cubic.on_ack(mss, 0, 100);
+            }
+            cubic.on_fast_retransmit(0);
+            cubic.on_recovery_exit();
+            cubic.on_ack(mss, 0, 100);  // the epoch begins at 70 segments
+
+            // 30 s later, W_cubic is thousands of segments
+            const size_t window = cubic.cwnd();
+            for (size_t acked = mss; acked <= window; acked += mss) {
+                cubic.on_ack(mss, 30000, 100);
+            }
+            if (cubic.cwnd() > window + window / 2) {
+                throw runtime_error("CUBIC grew from " + to_string(window / mss) + " to " +
+                                    to_string(cubic.cwnd() / mss) + " segments in one round trip");
+            }
+            if (cubic.cwnd() < window + window / 4) {
+                throw runtime_error("CUBIC should still grow quickly while far below the curve");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! The application corks or uncorks the connection
+struct SetCorked : public SenderAction {
+    bool corked;
+    explicit SetCorked(const bool corked_) : corked(corked_) {}
+    std::string description() const { return corked ? "cork" : "uncork"; }
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const { sender.set_corked(corked); }
+};
+
+//! The application turns Nagle's algorithm on or off
+struct SetNagle : public SenderAction {
+    bool nagle;
+    explicit SetNagle(const bool nagle_) : nagle(nagle_) {}
+    std::string description() const { return nagle ? "enable Nagle" : "disable Nagle"; }
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const { sender.set_nagle(nagle); }
+};
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"Nagle coalesces small writes while data is unacknowledged", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            // nothing in flight: the first small write goes at once
+            test.execute(WriteBytes{"GET / HTTP/1.1\r\n"});
+            test.execute(ExpectSegment{}.with_data("GET / HTTP/1.1\r\n"));
+            test.execute(WriteBytes{"Host: a\r\n"});
+            test.execute(WriteBytes{"Connection: close\r\n"});
+            test.execute(WriteBytes{"\r\n"});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 17}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_data("Host: a\r\nConnection: close\r\n\r\n"));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"Nagle sends full segments, and holds only the small tail", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(2 * mss + 10, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            // the tail plus this makes a full segment
+            test.execute(WriteBytes{string(mss - 10, 'y')});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            // ending the stream sends the tail with the FIN
+            test.execute(WriteBytes{"z"}.with_end_input(true));
+            test.execute(ExpectSegment{}.with_data("z").with_fin(true));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"Turning Nagle off sends what it held", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a"));
+            test.execute(WriteBytes{"b"});
+            test.execute(ExpectNoSegment{});
+            test.execute(SetNagle{false});
+            test.execute(ExpectSegment{}.with_data("b"));
+            test.execute(WriteBytes{"c"});
+            test.execute(ExpectSegment{}.with_data("c"));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Cork holds small segments even with nothing in flight", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(SetCorked{true});
+            test.execute(WriteBytes{"abc"});
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectNoSegment{});
+            test.execute(WriteBytes{string(mss, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(SetCorked{false});
+            test.execute(ExpectSegment{}.with_payload_size(6));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.send_capacity = 10;
+
+            TCPSenderTestHarness test{"Cork doesn't hold a full buffer the writer can't add to", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(SetCorked{true});
+            test.execute(WriteBytes{"abcde"});
+            test.execute(ExpectNoSegment{});
+            test.execute(WriteBytes{"fghij"});
+            test.execute(ExpectSegment{}.with_data("abcdefghij"));
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+using Algorithm = CongestionControl::Algorithm;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+
+            TCPSenderTestHarness test{"Pacing spreads the window over the RTT", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(Tick{100});
+            // SRTT = 100 ms, so 1.2 * 10000 / 100 = 120 bytes/ms: a segment every 8.33 ms
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(5 * mss, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{8});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            // a long tick releases every segment that fell due during it
+            test.execute(Tick{20});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{100});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+
+            TCPSenderTestHarness test{"Idle time doesn't build up a burst", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(Tick{1000});
+            test.execute(WriteBytes{string(2 * mss, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{9});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+            cfg.congestion_control = Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"In slow start, pacing runs at twice the window per RTT", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(Tick{100});
+            // cwnd = 10 segments: 2 * 10000 / 100 = 200 bytes/ms, a segment every 5 ms
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(3 * mss, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{4});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(Tick{5});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+
+            TCPSenderTestHarness test{"Without an RTT sample, nothing is paced", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(Tick{100});
+            test.execute(Tick{TCPConfig::TIMEOUT_DFLT});
+            test.execute(ExpectSegment{}.with_syn(true));
+            // Karn's rule: the ACK of the retransmitted SYN isn't timed
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(3 * mss, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"RTO follows the measured RTT", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectRTO{TCPConfig::TIMEOUT_DFLT});
+            test.execute(Tick{100});
+            // first sample: SRTT = 100, RTTVAR = 50, RTO = 100 + 4 * 50
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTO{300});
+            test.execute(WriteBytes{"abcd"});
+            test.execute(ExpectSegment{}.with_payload_size(4));
+            test.execute(Tick{100});
+            // RTTVAR = 3/4 * 50, so RTO = 100 + 4 * 37.5
+            test.execute(AckReceived{WrappingInt32{isn + 5}}.with_win(1000));
+            test.execute(ExpectRTO{250});
+            test.execute(WriteBytes{"efgh"});
+            test.execute(ExpectSegment{}.with_payload_size(4));
+            test.execute(Tick{249});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(4).with_data("efgh"));
+            test.execute(ExpectRTO{500});
+            // Karn's rule: the ACK of a retransmitted segment is not timed, so the RTO returns to 250
+            // even though 2 seconds passed
+            test.execute(Tick{2000 - 250});
+            test.execute(ExpectSegment{}.with_data("efgh"));
+            test.execute(AckReceived{WrappingInt32{isn + 9}}.with_win(1000));
+            test.execute(ExpectRTO{250});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.min_rto = 50;
+            cfg.max_rto = 150;
+
+            TCPSenderTestHarness test{"RTO stays within its bounds", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTO{50});
+            test.execute(WriteBytes{"abcd"});
+            test.execute(ExpectSegment{}.with_payload_size(4));
+            test.execute(Tick{50});
+            test.execute(ExpectSegment{}.with_payload_size(4));
+            test.execute(ExpectRTO{100});
+            test.execute(Tick{100});
+            test.execute(ExpectSegment{}.with_payload_size(4));
+            test.execute(ExpectRTO{150});
+            test.execute(Tick{150});
+            test.execute(ExpectSegment{}.with_payload_size(4));
+            test.execute(ExpectRTO{150});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const uint16_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            TCPSenderTestHarness test{"Without adaptive RTO, each ACK restores the initial RTO", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTO{rto});
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+using Algorithm = CongestionControl::Algorithm;
+
+//! Both SYNs carried SACK-permitted
+struct EnableSack : public SenderAction {
+    std::string description() const { return "enable SACK"; }
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const { sender.enable_sack(); }
+};
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        for (const Algorithm algorithm : {Algorithm::NewReno, Algorithm::Cubic}) {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = algorithm;
+            // sequence number of segment i
+            const auto seg = [&](const size_t i) { return isn + 1 + i * mss; };
+
+            TCPSenderTestHarness test{"Fast retransmit resends every SACK hole, and nothing SACKed", cfg};
+            test.execute(EnableSack{});
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes(string(10 * mss, 'x')));
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(i)));
+            }
+            // segments 0 and 3 are lost
+            test.execute(AckReceived{seg(0)}.with_win(60000).with_sack({{seg(1), seg(3)}}));
+            test.execute(AckReceived{seg(0)}.with_win(60000).with_sack({{seg(4), seg(5)}, {seg(1), seg(3)}}));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{seg(0)}.with_win(60000).with_sack({{seg(4), seg(6)}, {seg(1), seg(3)}}));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(0)));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(3)));
+            test.execute(ExpectNoSegment{});
+            // more SACKs for the segments behind the holes resend nothing
+            test.execute(AckReceived{seg(0)}.with_win(60000).with_sack({{seg(4), seg(10)}, {seg(1), seg(3)}}));
+            test.execute(ExpectNoSegment{});
+            // a partial ACK up to the hole already resent
+            test.execute(AckReceived{seg(3)}.with_win(60000).with_sack({{seg(4), seg(10)}}));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{seg(10)}.with_win(60000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const uint16_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+            const auto seg = [&](const size_t i) { return isn + 1 + i * mss; };
+
+            TCPSenderTestHarness test{"A timeout resends the SACK holes, not just the first segment", cfg};
+            test.execute(EnableSack{});
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes(string(6 * mss, 'x')));
+            for (size_t i = 0; i < 6; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(i)));
+            }
+            test.execute(AckReceived{seg(0)}.with_win(60000).with_sack({{seg(4), seg(5)}, {seg(1), seg(3)}}));
+            test.execute(Tick{rto});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(0)));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(3)));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{seg(6)}.with_win(60000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
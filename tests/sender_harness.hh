@@ -15,6 +15,8 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
@@ -99,6 +101,20 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectRTO : public SenderExpectation {
+    size_t _rto;
+
+    ExpectRTO(size_t rto) : _rto(rto) {}
+    std::string description() const { return "RTO of " + std::to_string(_rto) + " ms"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.rto() != _rto) {
+            throw SenderExpectationViolation("The TCPSender's RTO was " + std::to_string(sender.rto()) +
+                                             " ms, but it was expected to be " + std::to_string(_rto) + " ms");
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
@@ -191,11 +207,15 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    std::vector<TCPHeader::SackBlock> _sack{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        for (const auto &block : _sack) {
+            ss << " sack " << block.left << "-" << block.right;
+        }
         return ss.str();
     }
 
@@ -204,7 +224,15 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    AckReceived &with_sack(std::vector<TCPHeader::SackBlock> sack) {
+        _sack = std::move(sack);
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (not _sack.empty()) {
+            sender.sack_received(_ackno, _sack);
+        }
         sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
         sender.fill_window();
     }
@@ -394,7 +422,16 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config.send_capacity,
+                 config.rt_timeout,
+                 config.fixed_isn,
+                 config.mss,
+                 config.congestion_control,
+                 config.adaptive_rto,
+                 config.min_rto,
+                 config.max_rto,
+                 config.nagle,
+                 config.pacing)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
@@ -0,0 +1,131 @@
+#include "byte_stream.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "slab.hh"
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! The pre-pool serialization: header rendered to a std::string twice
+static string reference_serialize(const TCPSegment &seg, const uint32_t pseudo_checksum) {
+    TCPHeader header_out = seg.header();
+    header_out.cksum = 0;
+    InternetChecksum check(pseudo_checksum);
+    check.add(header_out.serialize());
+    check.add(seg.payload());
+    header_out.cksum = check.value();
+    return header_out.serialize() + seg.payload().copy();
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        TCPSegment seg;
+        seg.header().sport = 1234;
+        seg.header().dport = 80;
+        seg.header().ack = true;
+        seg.payload() = string(1000, 'x');
+
+        // pooled header serialization is byte-identical to the string path, including when the
+        // payload's cached checksum is reused across header changes and dropped on payload changes
+        for (unsigned int i = 0; i < 1000; i++) {
+            if (i % 100 == 0) {
+                seg.payload() = string(i / 100 + 995, char(rd()));
+            }
+            seg.header().seqno = WrappingInt32{static_cast<uint32_t>(rd())};
+            seg.header().win = static_cast<uint16_t>(rd());
+            const uint32_t pseudo_checksum = static_cast<uint32_t>(rd());
+            if (seg.serialize(pseudo_checksum).concatenate() != reference_serialize(seg, pseudo_checksum)) {
+                throw runtime_error("pooled TCPSegment::serialize differs from string serialization");
+            }
+        }
+
+        // a payload read with headroom leaves the stack as one contiguous Buffer, and once warm,
+        // building and dropping frames never reaches the heap
+        ByteStream stream{4 * TCPConfig::MAX_PAYLOAD_SIZE};
+        const string data(TCPConfig::MAX_PAYLOAD_SIZE, 'y');
+        InternetDatagram dgram;
+        dgram.header().len = dgram.header().hlen * 4 + TCPHeader::LENGTH + data.size();
+        size_t warm = 0;
+        for (unsigned int i = 0; i < 100000; i++) {
+            if (i == 2) {
+                warm = Slab::heap_allocations();
+            }
+            stream.write(data);
+            seg.payload() = stream.read_with_headroom(data.size(), Slab::PACKET_HEADROOM);
+            dgram.payload() = seg.serialize(dgram.header().pseudo_cksum());
+            EthernetFrame frame;
+            frame.header().type = EthernetHeader::TYPE_IPv4;
+            frame.payload() = dgram.serialize();
+            const BufferList wire = frame.serialize();
+            if (wire.buffers().size() != 1 or wire.size() != EthernetHeader::LENGTH + dgram.header().len) {
+                throw runtime_error("frame was not serialized into one contiguous Buffer");
+            }
+        }
+        if (Slab::heap_allocations() != warm) {
+            throw runtime_error("steady-state serialization allocated " + to_string(Slab::heap_allocations() - warm) +
+                                " slabs from the heap");
+        }
+
+        // the in-place frame parses back, checksums included, and so does a second serialization
+        // of the same datagram (whose headroom is now taken)
+        EthernetFrame frame;
+        frame.header().type = EthernetHeader::TYPE_IPv4;
+        frame.payload() = dgram.serialize();
+        for (const auto &wire : {frame.serialize(), dgram.serialize()}) {
+            Slab bytes = Slab::allocate();
+            bytes.append(wire.concatenate());
+            Buffer received{move(bytes)};
+            if (wire.size() != dgram.header().len) {
+                EthernetFrame parsed_frame;
+                if (parsed_frame.parse(received) != ParseResult::NoError) {
+                    throw runtime_error("failed to parse an in-place Ethernet frame");
+                }
+                received = parsed_frame.payload();
+            }
+            InternetDatagram parsed;
+            if (parsed.parse(received) != ParseResult::NoError) {
+                throw runtime_error("failed to parse a datagram held in a Slab");
+            }
+            TCPSegment parsed_seg;
+            if (parsed_seg.parse(parsed.payload(), parsed.header().pseudo_cksum()) != ParseResult::NoError or
+                parsed_seg.payload().copy() != data) {
+                throw runtime_error("failed to parse a TCP segment held in a Slab");
+            }
+        }
+
+        // a moved-from list is empty and usable, whether or not its Buffers had spilled past the inline slots
+        for (const size_t count : {BufferList::INLINE_BUFFERS - 1, 2 * BufferList::INLINE_BUFFERS}) {
+            BufferList from;
+            string expected;
+            for (size_t i = 0; i < count; i++) {
+                from.append(string(10, char('a' + i)));
+                expected += string(10, char('a' + i));
+            }
+            BufferList to{move(from)};
+            if (from.size() != 0 or not from.buffers().empty() or to.concatenate() != expected) {
+                throw runtime_error("moving a BufferList of " + to_string(count) + " should leave it empty");
+            }
+            from.append(string("again"));
+            BufferList assigned;
+            assigned = move(to);
+            if (from.concatenate() != "again" or to.size() != 0 or not to.buffers().empty() or
+                assigned.concatenate() != expected) {
+                throw runtime_error("a moved-from BufferList of " + to_string(count) + " should be reusable");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
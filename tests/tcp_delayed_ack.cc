@@ -0,0 +1,140 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "test_utils.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Count (and discard) the pure ACKs `from` has queued
+static size_t pure_acks(TCPConnection &from) {
+    size_t count = 0;
+    while (not from.segments_out().empty()) {
+        count += from.segments_out().front().length_in_sequence_space() == 0;
+        from.segments_out().pop();
+    }
+    return count;
+}
+
+int main() {
+    try {
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+        TCPConfig delayed;
+        delayed.delayed_ack_timeout = 40;
+
+        const auto connected = [&](TCPConnection &x, TCPConnection &y) {
+            x.connect();
+            deliver(x, y);
+            deliver(y, x);
+            deliver(x, y);
+            if (not y.segments_out().empty()) {
+                throw runtime_error("the handshake's ACK should not be acknowledged");
+            }
+        };
+
+        // bulk data: one ACK per two full segments
+        {
+            TCPConnection x{TCPConfig{}}, y{delayed};
+            connected(x, y);
+            x.write(string(10 * mss, 'x'));
+            if (deliver(x, y).segments != 10) {
+                throw runtime_error("expected ten data segments");
+            }
+            if (const size_t acks = pure_acks(y); acks != 5) {
+                throw runtime_error("expected 5 ACKs for 10 segments, got " + to_string(acks));
+            }
+        }
+
+        // a peer with a smaller MSS than ours still gets an ACK for every two of its full segments
+        {
+            TCPConfig small_mss;
+            small_mss.mss = 536;
+            TCPConnection x{small_mss}, y{delayed};
+            connected(x, y);
+            x.write(string(10 * 536, 'x'));
+            if (deliver(x, y).segments != 10) {
+                throw runtime_error("expected ten 536-byte segments");
+            }
+            if (const size_t acks = pure_acks(y); acks != 5) {
+                throw runtime_error("expected 5 ACKs for 10 small-MSS segments, got " + to_string(acks));
+            }
+        }
+
+        // a lone segment is acknowledged when the delay runs out
+        {
+            TCPConnection x{TCPConfig{}}, y{delayed};
+            connected(x, y);
+            x.write("hello");
+            deliver(x, y);
+            y.tick(39);
+            if (not y.segments_out().empty()) {
+                throw runtime_error("ACK sent before the delay ran out");
+            }
+            y.tick(1);
+            if (pure_acks(y) != 1) {
+                throw runtime_error("ACK not sent when the delay ran out");
+            }
+            y.tick(100);
+            if (not y.segments_out().empty()) {
+                throw runtime_error("ACK sent twice");
+            }
+        }
+
+        // out-of-order data is acknowledged at once, and so is the segment filling the hole
+        {
+            TCPConnection x{TCPConfig{}}, y{delayed};
+            connected(x, y);
+            x.write("first");
+            const TCPSegment first = x.segments_out().front();
+            x.segments_out().pop();
+            x.write("second");
+            deliver(x, y);
+            if (pure_acks(y) != 1) {
+                throw runtime_error("out-of-order segment should be acknowledged at once");
+            }
+            y.segment_received(first);
+            if (pure_acks(y) != 1) {
+                throw runtime_error("segment filling a hole should be acknowledged at once");
+            }
+        }
+
+        // FIN is acknowledged at once
+        {
+            TCPConnection x{TCPConfig{}}, y{delayed};
+            connected(x, y);
+            x.write("bye");
+            x.end_input_stream();
+            deliver(x, y);
+            if (pure_acks(y) != 1) {
+                throw runtime_error("FIN should be acknowledged at once");
+            }
+        }
+
+        // data going the other way carries the ACK, and the delayed one is dropped
+        {
+            TCPConnection x{TCPConfig{}}, y{delayed};
+            connected(x, y);
+            x.write("ping");
+            const WrappingInt32 ping = x.segments_out().front().header().seqno;
+            deliver(x, y);
+            y.write("pong");
+            if (y.segments_out().size() != 1 or not y.segments_out().front().header().ack or
+                y.segments_out().front().header().ackno != ping + 4) {
+                throw runtime_error("data segment should carry the ACK");
+            }
+            y.segments_out().pop();
+            y.tick(100);
+            if (not y.segments_out().empty()) {
+                throw runtime_error("piggybacked ACK should cancel the delayed one");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_mux.hh"
+#include "udp_client.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        constexpr size_t N = 16;
+        constexpr uint64_t LIMIT_MS = 10000;
+
+        UDPSocket server_sock;
+        server_sock.bind(Address("127.0.0.1", 0));
+        const Address server_address = server_sock.local_address();
+
+        // an echo server: every byte that arrives goes back, and the stream ends when the peer's does
+        UDPTCPMux server{UDPMuxLink{move(server_sock)}};
+        size_t accepted = 0, closed = 0;
+        server.on_accept([&](const FourTuple &, TCPConnection &) { accepted++; });
+        server.on_data([&](const FourTuple &, TCPConnection &conn) {
+            conn.write(conn.inbound_stream().read(conn.inbound_stream().buffer_size()));
+            if (conn.inbound_stream().eof()) {
+                conn.end_input_stream();
+            }
+        });
+        server.on_close([&](const FourTuple &, TCPConnection &conn) {
+            if (conn.state() != TCPState::State::CLOSED) {
+                throw runtime_error("server connection removed before closing cleanly");
+            }
+            closed++;
+        });
+        server.listen(server_address.port(), TCPConfig{});
+
+        // segments that aren't a SYN don't create connections
+        {
+            UDPSocket stray;
+            stray.bind(Address("127.0.0.1", 0));
+            TCPSegment ack;
+            ack.header().ack = true;
+            stray.sendto(server_address, ack.serialize(0));
+            server.wait_next_event(100);
+            if (server.size() != 0) {
+                throw runtime_error("a stray ACK created a connection");
+            }
+        }
+
+        // the clients are the active closers; keep their TIME_WAIT short
+        TCPConfig client_cfg;
+        client_cfg.rt_timeout = 10;
+
+        vector<UDPClient> clients;
+        vector<string> sent;
+        clients.reserve(N);
+        for (size_t i = 0; i < N; i++) {
+            UDPSocket sock;
+            sock.bind(Address("127.0.0.1", 0));
+            UDPClient &client = clients.emplace_back(client_cfg, move(sock), server_address);
+            sent.push_back("hello from client " + to_string(i));
+            client.tcp.connect();
+            client.tcp.write(sent.back());
+        }
+
+        // one more connection, opened by a second mux
+        UDPSocket mux_sock;
+        mux_sock.bind(Address("127.0.0.1", 0));
+        const Address mux_address = mux_sock.local_address();
+        UDPTCPMux client_mux{UDPMuxLink{move(mux_sock)}};
+        string mux_received;
+        client_mux.on_data([&](const FourTuple &, TCPConnection &conn) {
+            mux_received += conn.inbound_stream().read(conn.inbound_stream().buffer_size());
+        });
+        const FourTuple tuple{
+            mux_address.ipv4_numeric(), mux_address.port(), server_address.ipv4_numeric(), server_address.port()};
+        client_mux.connect(tuple, client_cfg);
+        client_mux.write(tuple, "hello from the mux");
+        client_mux.end_input_stream(tuple);
+
+        const auto done = [&] {
+            for (size_t i = 0; i < N; i++) {
+                if (clients[i].received != sent[i] or clients[i].tcp.active()) {
+                    return false;
+                }
+            }
+            return closed == N + 1 and mux_received == "hello from the mux" and client_mux.size() == 0;
+        };
+
+        const uint64_t start = timestamp_ms();
+        uint64_t last_tick = start;
+        while (not done() and timestamp_ms() - start < LIMIT_MS) {
+            for (size_t i = 0; i < N; i++) {
+                clients[i].pump();
+                if (clients[i].received == sent[i] and not clients[i].ended) {
+                    clients[i].tcp.end_input_stream();
+                    clients[i].ended = true;
+                }
+            }
+            server.wait_next_event(1);
+            client_mux.wait_next_event(0);
+
+            const uint64_t now = timestamp_ms();
+            if (now > last_tick) {
+                for (auto &client : clients) {
+                    client.tcp.tick(now - last_tick);
+                }
+                last_tick = now;
+            }
+        }
+
+        for (size_t i = 0; i < N; i++) {
+            if (clients[i].received != sent[i]) {
+                throw runtime_error("client expected \"" + sent[i] + "\" back, got \"" + clients[i].received + "\"");
+            }
+        }
+        if (mux_received != "hello from the mux") {
+            throw runtime_error("mux client got \"" + mux_received + "\" back");
+        }
+        if (accepted != N + 1 or closed != N + 1 or server.size() != 0) {
+            throw runtime_error("expected " + to_string(N + 1) + " connections accepted and closed, got " +
+                                to_string(accepted) + " and " + to_string(closed) + " (" + to_string(server.size()) +
+                                " left)");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
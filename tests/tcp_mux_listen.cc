@@ -0,0 +1,218 @@
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_mux.hh"
+#include "tcp_state.hh"
+#include "udp_client.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Let the clients and the server answer each other twice (enough for a handshake), handling
+//! everything that arrives at the server
+static void exchange(list<UDPClient> &clients, UDPTCPMux &server) {
+    for (unsigned int round = 0; round < 2; round++) {
+        for (auto &client : clients) {
+            client.pump();
+        }
+        while (server.wait_next_event(20) == EventLoop::Result::Success) {
+        }
+    }
+}
+
+static size_t established(const list<UDPClient> &clients) {
+    return count_if(clients.begin(), clients.end(), [](const UDPClient &c) { return c.established(); });
+}
+
+//! Close every connection (accepting whatever is still queued), and check they all close cleanly
+static void finish(list<UDPClient> &clients, UDPTCPMux &server, const uint16_t port) {
+    const uint64_t start = timestamp_ms();
+    uint64_t last_tick = start;
+    const auto done = [&] {
+        return server.size() == 0 and
+               all_of(clients.begin(), clients.end(), [](const UDPClient &c) { return not c.tcp.active(); });
+    };
+    while (not done() and timestamp_ms() - start < 10000) {
+        for (auto &client : clients) {
+            client.pump();
+            if (client.established() and not client.ended) {
+                client.tcp.end_input_stream();
+                client.ended = true;
+            }
+        }
+        server.wait_next_event(1);
+        while (server.accept(port).has_value()) {
+        }
+
+        const uint64_t now = timestamp_ms();
+        if (now > last_tick) {
+            for (auto &client : clients) {
+                client.tcp.tick(now - last_tick);
+            }
+            last_tick = now;
+        }
+    }
+    if (not done()) {
+        throw runtime_error("connections did not all close");
+    }
+}
+
+int main() {
+    try {
+        constexpr size_t N = 5;
+        TCPConfig client_cfg;
+        client_cfg.rt_timeout = 100;
+
+        const auto make_server = [] {
+            UDPSocket sock;
+            sock.bind(Address("127.0.0.1", 0));
+            auto server = make_unique<UDPTCPMux>(UDPMuxLink{move(sock)});
+            // the peer's end of the stream ends ours
+            server->on_data([](const FourTuple &, TCPConnection &conn) {
+                if (conn.inbound_stream().eof() and conn.state() == TCPState::State::CLOSE_WAIT) {
+                    conn.end_input_stream();
+                }
+            });
+            return server;
+        };
+
+        // bounded queues: SYNs beyond the SYN queue are dropped, and nothing completes while the accept
+        // queue is full
+        {
+            const auto server = make_server();
+            const Address server_address = static_cast<UDPSocket &>(server->link().fd()).local_address();
+            const uint16_t port = server_address.port();
+            server->listen(port, TCPConfig{}, {2, 2, false});
+
+            list<UDPClient> clients;
+            for (size_t i = 0; i < N; i++) {
+                UDPSocket client_sock;
+                client_sock.bind(Address("127.0.0.1", 0));
+                clients.emplace_back(client_cfg, move(client_sock), server_address).tcp.connect();
+            }
+
+            exchange(clients, *server);
+            if (server->syn_queue_size(port) != 0 or server->accept_queue_size(port) != 2 or
+                established(clients) != 2) {
+                throw runtime_error("expected two of five handshakes to complete");
+            }
+
+            // listening again would lose the queued connections
+            bool rejected = false;
+            try {
+                server->listen(port, TCPConfig{}, {8, 8, false});
+            } catch (const runtime_error &) {
+                rejected = true;
+            }
+            if (not rejected or server->accept_queue_size(port) != 2) {
+                throw runtime_error("a second listen() on the port should fail and leave its queues alone");
+            }
+
+            // the SYNs are retransmitted, but there's no room in the accept queue
+            for (auto &client : clients) {
+                client.tcp.tick(client_cfg.rt_timeout);
+            }
+            exchange(clients, *server);
+            if (server->syn_queue_size(port) != 0 or established(clients) != 2) {
+                throw runtime_error("a SYN was admitted while the accept queue was full");
+            }
+
+            // accepting makes room, and the next retransmissions get in
+            for (unsigned int i = 0; i < 2; i++) {
+                const auto tuple = server->accept(port);
+                if (not tuple.has_value() or
+                    none_of(clients.begin(), clients.end(), [&](const UDPClient &c) {
+                        return c.established() and c.address.port() == tuple->remote_port;
+                    })) {
+                    throw runtime_error("accept() should return an established connection");
+                }
+            }
+            if (server->accept(port).has_value()) {
+                throw runtime_error("accept() with an empty queue");
+            }
+            for (auto &client : clients) {
+                client.tcp.tick(2 * client_cfg.rt_timeout);
+            }
+            exchange(clients, *server);
+            if (server->accept_queue_size(port) != 2 or established(clients) != 4) {
+                throw runtime_error("expected two more handshakes to complete");
+            }
+
+            finish(clients, *server, port);
+        }
+
+        // SYN cookies: a full SYN queue doesn't stop handshakes completing, and the cookie remembers
+        // the peer's MSS
+        {
+            TCPConfig small_mss = client_cfg;
+            small_mss.mss = 536;
+            const auto server = make_server();
+            const Address server_address = static_cast<UDPSocket &>(server->link().fd()).local_address();
+            const uint16_t port = server_address.port();
+            server->listen(port, TCPConfig{}, {1, 8, true});
+
+            list<UDPClient> clients;
+            for (size_t i = 0; i < N; i++) {
+                UDPSocket client_sock;
+                client_sock.bind(Address("127.0.0.1", 0));
+                clients.emplace_back(small_mss, move(client_sock), server_address).tcp.connect();
+            }
+
+            exchange(clients, *server);
+            if (server->syn_queue_size(port) != 0 or server->accept_queue_size(port) != N or
+                established(clients) != N) {
+                throw runtime_error("expected every handshake to complete with SYN cookies");
+            }
+
+            // the connections a cookie rebuilt carry data like any other
+            for (auto &client : clients) {
+                client.tcp.write("hello from " + to_string(client.address.port()));
+            }
+            exchange(clients, *server);
+            for (auto tuple = server->accept(port); tuple.has_value(); tuple = server->accept(port)) {
+                ByteStream &stream = server->find(tuple.value())->inbound_stream();
+                const string expected = "hello from " + to_string(tuple->remote_port);
+                if (stream.read(stream.buffer_size()) != expected) {
+                    throw runtime_error("wrong data on a connection made from a SYN cookie");
+                }
+                server->write(tuple.value(), string(2000, 'x'));
+            }
+            exchange(clients, *server);
+            for (const auto &client : clients) {
+                if (client.largest_payload != 536) {
+                    throw runtime_error("expected 536-byte segments from the server, got " +
+                                        to_string(client.largest_payload));
+                }
+            }
+
+            // an ACK without a valid cookie is dropped
+            UDPSocket stray;
+            stray.bind(Address("127.0.0.1", 0));
+            TCPSegment ack;
+            ack.header().ack = true;
+            ack.header().seqno = WrappingInt32{1000};
+            ack.header().ackno = WrappingInt32{12345};
+            stray.sendto(server_address, ack.serialize(0));
+            server->wait_next_event(100);
+            if (server->size() != N) {
+                throw runtime_error("an ACK with a forged cookie created a connection");
+            }
+
+            finish(clients, *server, port);
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
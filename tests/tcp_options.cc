@@ -0,0 +1,309 @@
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "test_utils.hh"
+
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Open a connection between `x` and `y` and stream `len` bytes from x without reading them at y.
+//! Returns the most bytes x ever had in flight and the largest payload it sent.
+static pair<size_t, size_t> stream(const TCPConfig &x_config, const TCPConfig &y_config, const size_t len) {
+    TCPConnection x{x_config}, y{y_config};
+    x.connect();
+    deliver(x, y);
+    deliver(y, x);
+
+    x.write(string(len, 'x'));
+    size_t in_flight = 0, largest = 0;
+    for (unsigned int round = 0; round < 100; round++) {
+        in_flight = max(in_flight, x.bytes_in_flight());
+        largest = max(largest, deliver(x, y).largest_payload);
+        deliver(y, x);
+    }
+    return {in_flight, largest};
+}
+
+int main() {
+    try {
+        // options survive a serialize/parse round trip and grow the header
+        {
+            TCPHeader header;
+            header.syn = true;
+            header.mss = 1460;
+            header.wscale = 7;
+            header.timestamps = TCPHeader::Timestamps{0xdeadbeef, 42};
+            if (header.length() != TCPHeader::LENGTH + 20) {
+                throw runtime_error("MSS, window scale and timestamps should add 20 bytes to the header");
+            }
+            const string bytes = header.serialize();
+            NetParser p{Buffer{string(bytes)}};
+            TCPHeader parsed;
+            if (parsed.parse(p) != ParseResult::NoError or parsed.doff != 10 or not parsed.syn or
+                parsed.mss != header.mss or parsed.wscale != header.wscale or parsed.timestamps != header.timestamps) {
+                throw runtime_error("TCP options did not round-trip:\n" + parsed.to_string());
+            }
+        }
+
+        // SACK blocks share the option space with timestamps: three fit alongside them, four without
+        {
+            TCPHeader header;
+            header.ack = true;
+            for (uint32_t i = 0; i < 5; i++) {
+                header.sack.push_back({WrappingInt32{100 * i}, WrappingInt32{100 * i + 50}});
+            }
+            header.timestamps = TCPHeader::Timestamps{7, 8};
+            if (header.sack_capacity() != 3 or header.length() != TCPHeader::LENGTH + 40) {
+                throw runtime_error("SACK blocks should fill the option space alongside timestamps");
+            }
+            NetParser p{Buffer{header.serialize()}};
+            TCPHeader parsed;
+            if (parsed.parse(p) != ParseResult::NoError or parsed.sack.size() != 3 or
+                parsed.sack.at(2) != header.sack.at(2) or parsed.timestamps != header.timestamps) {
+                throw runtime_error("SACK blocks did not round-trip:\n" + parsed.to_string());
+            }
+            header.timestamps.reset();
+            if (header.sack_capacity() != 4) {
+                throw runtime_error("four SACK blocks should fit without timestamps");
+            }
+        }
+
+        // unknown options are skipped, and a malformed option ends the list without failing the parse
+        {
+            TCPHeader header;
+            header.doff = 10;  // room for 20 bytes of options
+            string bytes = header.serialize();
+            const string options = string{4, 2}                                   // SACK permitted
+                                   + string{8, 10, 0, 0, 0, 1, 0, 0, 0, 2}        // timestamps
+                                   + string{1, 2, 4, 0x05, char(0xb4)} + string{3, 0};  // MSS 1460, truncated WS
+            bytes.replace(TCPHeader::LENGTH, options.size(), options);
+            NetParser p{Buffer{move(bytes)}};
+            TCPHeader parsed;
+            if (parsed.parse(p) != ParseResult::NoError or parsed.mss != 1460 or parsed.wscale.has_value() or
+                parsed.timestamps != TCPHeader::Timestamps{1, 2}) {
+                throw runtime_error("bad parse of a mixed option list:\n" + parsed.to_string());
+            }
+        }
+
+        const size_t len = 1024 * 1024;
+        TCPConfig large;
+        large.recv_capacity = large.send_capacity = len;
+
+        // both sides scale their windows: far more than 64 KiB is in flight
+        {
+            const auto [in_flight, largest] = stream(large, large, len);
+            if (in_flight <= numeric_limits<uint16_t>::max()) {
+                throw runtime_error("window scaling did not open the window past 64 KiB (in flight: " +
+                                    to_string(in_flight) + ")");
+            }
+            if (in_flight > len) {
+                throw runtime_error("sender overran the peer's window");
+            }
+            if (largest != TCPConfig::MAX_PAYLOAD_SIZE) {
+                throw runtime_error("segments should be MSS-sized");
+            }
+        }
+
+        // a peer that doesn't offer window scaling caps the window at 64 KiB
+        {
+            TCPConfig unscaled = large;
+            unscaled.window_scaling = false;
+            if (stream(large, unscaled, len).first > numeric_limits<uint16_t>::max()) {
+                throw runtime_error("window scaled without the peer's agreement");
+            }
+        }
+
+        // ...and isn't sent a window scale option on the SYN/ACK
+        {
+            TCPConfig unscaled = large;
+            unscaled.window_scaling = false;
+            TCPConnection x{unscaled}, y{large};
+            x.connect();
+            if (x.segments_out().front().header().wscale.has_value()) {
+                throw runtime_error("SYN offered window scaling that wasn't configured");
+            }
+            deliver(x, y);
+            if (y.segments_out().empty() or y.segments_out().front().header().wscale.has_value()) {
+                throw runtime_error("SYN/ACK carried a window scale the SYN didn't offer");
+            }
+            deliver(y, x);
+        }
+
+        // the smaller of the two MSS options wins
+        {
+            TCPConfig big_mss = large, small_mss = large;
+            big_mss.mss = 1460;
+            small_mss.mss = 536;
+            if (stream(big_mss, small_mss, len).second != 536) {
+                throw runtime_error("sender ignored the peer's MSS");
+            }
+            if (stream(big_mss, big_mss, len).second != 1460) {
+                throw runtime_error("sender ignored its configured MSS");
+            }
+        }
+
+        // a duplicate SYN/ACK in the middle of a transfer changes neither the MSS nor the congestion window
+        {
+            TCPConfig reno = large, small_mss = large;
+            reno.congestion_control = CongestionControl::Algorithm::NewReno;
+            small_mss.mss = 536;
+            TCPConnection x{reno}, y{small_mss};
+            x.connect();
+            deliver(x, y);
+            const TCPSegment syn_ack = y.segments_out().front();
+            deliver(y, x);
+            x.write(string(len, 'x'));
+            // slow start: ten segments, whose ACKs let twenty out
+            deliver(x, y);
+            deliver(y, x);
+            const size_t in_flight = x.bytes_in_flight();
+            if (in_flight != 20 * 536) {
+                throw runtime_error("expected twenty segments in flight, got " + to_string(in_flight) + " bytes");
+            }
+
+            x.segment_received(syn_ack);
+            const size_t largest = deliver(x, y).largest_payload;
+            deliver(y, x);
+            if (largest != 536 or x.bytes_in_flight() != 2 * in_flight) {
+                throw runtime_error("a duplicate SYN/ACK reset the congestion window (" +
+                                    to_string(x.bytes_in_flight()) + " bytes in flight)");
+            }
+        }
+
+        // timestamps: negotiated only if both SYNs carry them; every ACK then yields an RTT sample
+        {
+            TCPConfig no_timestamps;
+            no_timestamps.timestamps = false;
+            TCPConnection x{TCPConfig{}}, y{no_timestamps};
+            x.connect();
+            if (not x.segments_out().front().header().timestamps.has_value()) {
+                throw runtime_error("SYN should offer timestamps");
+            }
+            deliver(x, y);
+            if (y.segments_out().front().header().timestamps.has_value()) {
+                throw runtime_error("SYN/ACK offered timestamps the SYN didn't");
+            }
+            deliver(y, x);
+            x.write("hello");
+            if (x.segments_out().front().header().timestamps.has_value()) {
+                throw runtime_error("timestamps sent without being negotiated");
+            }
+        }
+
+        {
+            TCPConnection x{TCPConfig{}}, y{TCPConfig{}};
+            x.connect();
+            deliver(x, y);
+            deliver(y, x);
+            deliver(x, y);
+            x.write("hello");
+            TCPSegment data = x.segments_out().front();
+            if (not data.header().timestamps.has_value()) {
+                throw runtime_error("data segment should carry timestamps");
+            }
+            deliver(x, y);
+            deliver(y, x);
+            if (not x.srtt().has_value()) {
+                throw runtime_error("the ACK's timestamp echo should have produced an RTT sample");
+            }
+
+            // PAWS: an old duplicate whose TSval predates TS.Recent is dropped (and answered with an ACK),
+            // even though its sequence numbers land in the window
+            x.write("world");
+            TCPSegment next = x.segments_out().front();
+            x.segments_out().pop();
+            next.header().timestamps.value().tsval -= 1000;
+            y.segment_received(next);
+            if (y.inbound_stream().buffer_size() != 5 or y.unassembled_bytes() != 0) {
+                throw runtime_error("PAWS should have rejected the old segment");
+            }
+            if (y.segments_out().size() != 1 or y.segments_out().front().header().ackno != data.header().seqno + 5) {
+                throw runtime_error("a PAWS-rejected segment should be acknowledged");
+            }
+            y.segments_out().pop();
+            next.header().timestamps.value().tsval += 1000;
+            y.segment_received(next);
+            if (y.inbound_stream().read(10) != "helloworld") {
+                throw runtime_error("a current segment should be accepted");
+            }
+        }
+
+        // timestamps count tick() time, so RTT samples are right however fast the caller's clock runs
+        {
+            TCPConnection x{TCPConfig{}}, y{TCPConfig{}};
+            x.connect();
+            x.tick(50);
+            deliver(x, y);
+            deliver(y, x);
+            deliver(x, y);
+            x.write("hello");
+            x.tick(50);
+            deliver(x, y);
+            deliver(y, x);
+            if (x.srtt() != 50.0) {
+                throw runtime_error("expected an SRTT of 50 ms from ticks alone, got " +
+                                    (x.srtt().has_value() ? to_string(x.srtt().value()) : string("none")));
+            }
+        }
+
+        // a bogus timestamp echo (zero, ahead of the sender's clock, or absurdly old) is no RTT sample:
+        // the sender times the ACK itself instead
+        {
+            // x sends data at 200050 ms and its ACK arrives at 200100 ms
+            const uint32_t now = 200100;
+            for (const uint32_t tsecr : {uint32_t{0}, now + 1000, now - 100000}) {
+                TCPConnection x{TCPConfig{}}, y{TCPConfig{}};
+                x.connect();
+                x.tick(50);
+                deliver(x, y);
+                deliver(y, x);
+                deliver(x, y);
+                x.tick(200000);
+                x.write("hello");
+                x.tick(50);
+                deliver(x, y);
+                TCPSegment ack = y.segments_out().front();
+                y.segments_out().pop();
+                ack.header().timestamps.value().tsecr = tsecr;
+                x.segment_received(ack);
+                if (x.srtt() != 50.0) {
+                    throw runtime_error("a TSecr of " + to_string(tsecr) + " at " + to_string(now) +
+                                        " ms should have been ignored, got SRTT " +
+                                        (x.srtt().has_value() ? to_string(x.srtt().value()) : string("none")));
+                }
+            }
+        }
+
+        // SACK: negotiated on the SYNs; an ACK for out-of-order data describes what is held
+        {
+            TCPConnection x{TCPConfig{}}, y{TCPConfig{}};
+            x.connect();
+            if (not x.segments_out().front().header().sack_permitted) {
+                throw runtime_error("SYN should offer SACK");
+            }
+            deliver(x, y);
+            deliver(y, x);
+            deliver(x, y);
+            x.write(string(3 * TCPConfig::MAX_PAYLOAD_SIZE, 'x'));
+            x.segments_out().pop();  // the first segment is lost
+            const WrappingInt32 second = x.segments_out().front().header().seqno;
+            deliver(x, y);
+            const auto &sack = y.segments_out().back().header().sack;
+            if (sack.size() != 1 or sack.front().left != second or
+                sack.front().right != second + 2 * TCPConfig::MAX_PAYLOAD_SIZE) {
+                throw runtime_error("ACK should SACK the two segments received out of order");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,13 +1,17 @@
 #ifndef SPONGE_TESTS_TEST_UTILS_HH
 #define SPONGE_TESTS_TEST_UTILS_HH
 
+#include "tcp_connection.hh"
 #include "tcp_header.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <pcap/pcap.h>
+#include <utility>
 
 inline void show_ethernet_frame(const uint8_t *pkt, const struct pcap_pkthdr &hdr) {
     const auto flags(std::cout.flags());
@@ -39,4 +43,22 @@ inline bool compare_tcp_headers(const TCPHeader &h1, const TCPHeader &h2) {
     return compare_tcp_headers_nolen(h1, h2) && h1.doff == h2.doff;
 }
 
+//! What deliver() handed over
+struct Delivered {
+    size_t segments = 0;         //!< how many segments
+    size_t largest_payload = 0;  //!< the largest payload among them
+};
+
+//! Deliver everything `from` has queued to `to`
+inline Delivered deliver(TCPConnection &from, TCPConnection &to) {
+    Delivered delivered{};
+    while (not from.segments_out().empty()) {
+        delivered.segments++;
+        delivered.largest_payload = std::max(delivered.largest_payload, from.segments_out().front().payload().size());
+        to.segment_received(std::move(from.segments_out().front()));
+        from.segments_out().pop();
+    }
+    return delivered;
+}
+
 #endif  // SPONGE_TESTS_TEST_UTILS_HH
@@ -0,0 +1,156 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "test_utils.hh"
+#include "timer_wheel.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void expect_timeout(const TCPConnection &conn, const optional<size_t> expected, const string &what) {
+    const auto actual = conn.next_timeout();
+    if (actual != expected) {
+        throw runtime_error(what + ": expected next_timeout " +
+                            (expected.has_value() ? to_string(expected.value()) : "none") + ", got " +
+                            (actual.has_value() ? to_string(actual.value()) : "none"));
+    }
+}
+
+int main() {
+    try {
+        // random schedules, cancels and jumps in time, against a list of deadlines
+        {
+            mt19937_64 rng{12345};
+            TimerWheel<uint64_t> wheel;
+            map<TimerWheel<uint64_t>::TimerId, uint64_t> pending;  // id -> deadline
+            uint64_t fired = 0;
+
+            for (unsigned int round = 0; round < 20000; round++) {
+                const unsigned int op = rng() % 8;
+                if (op < 4) {
+                    // deadlines near and far, up to beyond the top level's span
+                    const unsigned int bits = 1 + rng() % 27;
+                    const uint64_t deadline = wheel.now() + (rng() & ((uint64_t{1} << bits) - 1));
+                    const uint64_t effective = deadline > wheel.now() ? deadline : wheel.now() + 1;
+                    const auto id = wheel.schedule(deadline, effective);
+                    pending[id] = effective;
+                } else if (op < 5 and not pending.empty()) {
+                    auto victim = pending.begin();
+                    advance(victim, rng() % pending.size());
+                    if (not wheel.cancel(victim->first)) {
+                        throw runtime_error("cancel() failed for a pending timer");
+                    }
+                    pending.erase(victim);
+                } else {
+                    const unsigned int bits = rng() % 2 ? 1 + rng() % 8 : 1 + rng() % 26;
+                    const uint64_t target = wheel.now() + (rng() & ((uint64_t{1} << bits) - 1));
+                    uint64_t last = 0;
+                    wheel.advance(target, [&](const uint64_t deadline) {
+                        if (deadline != wheel.now()) {
+                            throw runtime_error("timer for " + to_string(deadline) + " expired at " +
+                                                to_string(wheel.now()));
+                        }
+                        if (deadline < last) {
+                            throw runtime_error("timers expired out of order");
+                        }
+                        last = deadline;
+                        fired++;
+                    });
+                    for (auto it = pending.begin(); it != pending.end();) {
+                        it = it->second <= target ? pending.erase(it) : next(it);
+                    }
+                    if (wheel.now() != target) {
+                        throw runtime_error("advance() should leave the time at its target");
+                    }
+                }
+                if (wheel.size() != pending.size()) {
+                    throw runtime_error("expected " + to_string(pending.size()) + " timers, have " +
+                                        to_string(wheel.size()));
+                }
+                // sleeping until next_expiry() mustn't oversleep any deadline
+                uint64_t earliest = UINT64_MAX;
+                for (const auto &entry : pending) {
+                    earliest = min(earliest, entry.second);
+                }
+                if (wheel.next_expiry().value_or(UINT64_MAX) > earliest) {
+                    throw runtime_error("next_expiry() is later than the earliest deadline");
+                }
+            }
+            if (fired == 0) {
+                throw runtime_error("no timers expired");
+            }
+        }
+
+        // a cancelled timer doesn't fire, and timers may be scheduled while expiring
+        {
+            TimerWheel<int> wheel{1000};
+            vector<int> order;
+            const auto cancelled = wheel.schedule(1100, 0);
+            wheel.schedule(1050, 1);
+            wheel.schedule(900, 2);  // already past: expires at once
+            if (not wheel.cancel(cancelled) or wheel.cancel(cancelled)) {
+                throw runtime_error("cancel() should succeed exactly once");
+            }
+            wheel.advance(1000000, [&](const int value) {
+                order.push_back(value);
+                if (value == 1) {
+                    wheel.schedule(wheel.now() + 5000, 3);
+                }
+            });
+            if (order != vector<int>{2, 1, 3} or wheel.size() != 0 or wheel.next_expiry().has_value()) {
+                throw runtime_error("wrong expiries");
+            }
+        }
+
+        // connections report their next deadline: the RTO, a delayed ACK, lingering
+        {
+            TCPConfig cfg;
+            cfg.rt_timeout = 100;
+            TCPConfig delayed = cfg;
+            delayed.delayed_ack_timeout = 40;
+            TCPConnection x{cfg}, y{delayed};
+            expect_timeout(x, {}, "idle");
+
+            x.connect();
+            expect_timeout(x, 100, "SYN sent");
+            x.tick(30);
+            expect_timeout(x, 70, "SYN outstanding");
+            deliver(x, y);
+            deliver(y, x);
+            deliver(x, y);
+            expect_timeout(x, {}, "established, nothing outstanding");
+
+            x.write("hello");
+            deliver(x, y);
+            expect_timeout(y, 40, "ACK delayed");
+            y.tick(40);
+            deliver(y, x);
+            expect_timeout(x, {}, "data acknowledged");
+
+            x.end_input_stream();
+            deliver(x, y);
+            deliver(y, x);
+            y.end_input_stream();
+            deliver(y, x);
+            deliver(x, y);
+            expect_timeout(x, 10 * cfg.rt_timeout, "lingering");
+            x.tick(400);
+            expect_timeout(x, 10 * cfg.rt_timeout - 400, "still lingering");
+            x.tick(10 * cfg.rt_timeout);
+            expect_timeout(x, {}, "closed");
+            expect_timeout(y, {}, "passive closer closed");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,53 @@
+#ifndef SPONGE_TESTS_UDP_CLIENT_HH
+#define SPONGE_TESTS_UDP_CLIENT_HH
+
+#include "fd_adapter.hh"
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_state.hh"
+#include "util.hh"
+
+#include <poll.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+//! A TCPConnection with its own UDP socket, speaking TCP-over-UDP to a server (a TCPMux) through a
+//! TCPOverUDPSocketAdapter
+struct UDPClient {
+    TCPConnection tcp;
+    TCPOverUDPSocketAdapter link;
+    Address address;             //!< the client's own address
+    std::string received{};      //!< everything read from the inbound stream so far
+    size_t largest_payload = 0;  //!< the largest payload the server has sent
+    bool ended = false;          //!< the test has ended the outbound stream
+
+    //! Built in place, since a moved-from TCPConnection still counts as open when destroyed
+    UDPClient(const TCPConfig &cfg, UDPSocket &&sock, const Address &server)
+        : tcp(cfg), link(std::move(sock)), address(static_cast<const UDPSocket &>(link).local_address()) {
+        link.config_mut().source = address;
+        link.config_mut().destination = server;
+    }
+
+    bool established() const { return tcp.state() == TCPState::State::ESTABLISHED; }
+
+    //! Read whatever has arrived, write what the connection wants to send, and collect the inbound stream
+    void pump() {
+        pollfd pfd{static_cast<const FileDescriptor &>(static_cast<const UDPSocket &>(link)).fd_num(), POLLIN, 0};
+        while (SystemCall("poll", ::poll(&pfd, 1, 0)) > 0) {
+            if (auto seg = link.read(); seg.has_value()) {
+                largest_payload = std::max(largest_payload, seg->payload().size());
+                tcp.segment_received(seg.value());
+            }
+        }
+        while (not tcp.segments_out().empty()) {
+            link.write(tcp.segments_out().front());
+            tcp.segments_out().pop();
+        }
+        received += tcp.inbound_stream().read(tcp.inbound_stream().buffer_size());
+    }
+};
+
+#endif  // SPONGE_TESTS_UDP_CLIENT_HH